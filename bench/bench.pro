@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += tilegeometry \
+    minmax \
+    timelag \
+    soak \
+    rolling
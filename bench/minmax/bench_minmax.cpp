@@ -0,0 +1,307 @@
+#include <QElapsedTimer>
+#include <QPoint>
+#include <QVector>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "minmaxpyramid.h"
+
+// AVX2-вариант столбцов собирается атрибутом target (GCC/Clang на x86), как ядра в minmaxpyramid.cpp
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BENCH_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define BENCH_HAVE_AVX2 0
+#endif
+
+// синтетический канал из BENCH_SAMPLES отсчетов
+#define BENCH_SAMPLES (qint64(1) << 24)
+// интервал между пиками, отсчетов
+#define BENCH_EVENT_INTERVAL 200
+// ширина и высота кадра, пикс
+#define BENCH_COLUMNS 2048
+#define BENCH_HEIGHT 60
+// минимальная длительность замера одного варианта, нс
+#define BENCH_MIN_TIME_NS 200000000LL
+
+#if BENCH_HAVE_AVX2
+// минимум и максимум отсчетов [0, count) по 4 отсчета за шаг, результат совпадает со скалярным
+__attribute__((target("avx2")))
+static inline void findMinMaxAvx2(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    qint64 i = 0;
+    minValue = maxValue = pSamples[0];
+    if (count >= 4) {
+        __m256d minVector = _mm256_set1_pd(pSamples[0]);
+        __m256d maxVector = minVector;
+        for (; i + 4 <= count; i += 4) {
+            __m256d value = _mm256_loadu_pd(pSamples + i);
+            minVector = _mm256_min_pd(value, minVector);
+            maxVector = _mm256_max_pd(value, maxVector);
+        }
+        double mins[4], maxs[4];
+        _mm256_storeu_pd(mins, minVector);
+        _mm256_storeu_pd(maxs, maxVector);
+        for (int k = 0; k < 4; k++) {
+            if (minValue > mins[k]) minValue = mins[k];
+            if (maxValue < maxs[k]) maxValue = maxs[k];
+        }
+    }
+    for (; i < count; i++) {
+        double value = pSamples[i];
+        if (minValue > value) minValue = value;
+        if (maxValue < value) maxValue = value;
+    }
+}
+
+// координаты Y четырех значений: округление до float и YMapping::toY, усечение _mm256_cvttpd_epi32
+// совпадает с приведением (qint32) в скалярном toY
+__attribute__((target("avx2")))
+static inline __m128i mapToYAvx2(__m256d values, const MinMaxPyramid::YMapping & mapping)
+{
+    values = _mm256_cvtps_pd(_mm256_cvtpd_ps(values));
+    __m256d offsets = _mm256_mul_pd(_mm256_sub_pd(values, _mm256_set1_pd(mapping.meanValue)), _mm256_set1_pd(mapping.scale));
+    __m128i y = _mm_sub_epi32(_mm_set1_epi32(mapping.startY), _mm256_cvttpd_epi32(offsets));
+    y = _mm_max_epi32(y, _mm_setzero_si128());
+    return _mm_min_epi32(y, _mm_set1_epi32(mapping.height - 1));
+}
+
+// вариант MinMaxPyramid::buildColumns по 4 столбца: минимумы и максимумы AVX2, координаты Y четырех столбцов
+// одним вектором (в отрисовку не вошел: по отсчетам строятся только столбцы короче 32 отсчетов, на них он медленнее)
+__attribute__((target("avx2")))
+static qint32 buildColumnsAvx2(const double * pSamples, qint64 count, double samplesPerPixel, qint64 firstX,
+                               qint32 columnStep, qint32 columnCount, const MinMaxPyramid::YMapping & mapping,
+                               MinMaxPyramid::Column * pColumns)
+{
+    for (qint32 column = 0; column < columnCount; column += 4) {
+        double mins[4], maxs[4];
+        qint32 ready = 0;
+        for (; ready < 4 && column + ready < columnCount; ready++) {
+            qint64 absX = firstX + qint64(column + ready) * columnStep;
+            qint64 beginSample = qint64(double(absX) * samplesPerPixel);
+            qint64 endSample = qint64(double(absX + columnStep) * samplesPerPixel);
+            if (beginSample >= count) {
+                break;
+            }
+            if (endSample <= beginSample) endSample = beginSample + 1;
+            if (endSample > count) endSample = count;
+            findMinMaxAvx2(pSamples + beginSample, endSample - beginSample, mins[ready], maxs[ready]);
+            pColumns[column + ready].falling = float(pSamples[beginSample]) > float(pSamples[endSample - 1]);
+        }
+        for (qint32 k = ready; k < 4; k++) {
+            mins[k] = maxs[k] = mapping.meanValue;
+        }
+        qint32 tops[4], bottoms[4];
+        _mm_storeu_si128((__m128i *)tops, mapToYAvx2(_mm256_loadu_pd(maxs), mapping));
+        _mm_storeu_si128((__m128i *)bottoms, mapToYAvx2(_mm256_loadu_pd(mins), mapping));
+        for (qint32 k = 0; k < ready; k++) {
+            pColumns[column + k].yTop = tops[k];
+            pColumns[column + k].yBottom = bottoms[k];
+        }
+        if (ready < 4) {
+            return column + ready;
+        }
+    }
+    return columnCount;
+}
+
+static bool cpuHasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#else
+static bool cpuHasAvx2()
+{
+    return false;
+}
+#endif
+
+// замер прореживания кадра из BENCH_COLUMNS столбцов при 10^3..10^7 отсчетов на кадр:
+// поотсчетный цикл из прежнего paintEvent, столбцы MinMaxPyramid::buildColumns и их AVX2-вариант
+// и столбцы по пирамиде, как в WaveformRenderer::computeTileGeometry
+class MinMaxBench
+{
+public:
+    MinMaxBench();
+    void run();
+
+private:
+    //
+    std::vector<double> mSamples;
+    //
+    MinMaxPyramid mPyramid;
+    //
+    MinMaxPyramid::YMapping mMapping;
+    // столбцы и вершины ломаной кадра
+    QVector<MinMaxPyramid::Column> mColumns;
+    QVector<QPoint> mPoints;
+    // контрольная сумма вершин, чтобы компилятор не выбросил замеряемый код
+    qint64 mChecksum;
+
+    // прежний цикл по отсчетам [beginSample, beginSample + samplesCount) с координатой X каждого отсчета
+    qint32 runPerSample(qint64 beginSample, qint64 samplesCount);
+    // столбцы по исходным отсчетам: MinMaxPyramid::buildColumns или AVX2-вариант
+    qint32 runKernel(double samplesPerPixel, bool avx2);
+    // столбцы по сводкам уровня пирамиды (buildColumns при уровне -1)
+    qint32 runPyramid(double samplesPerPixel);
+    // вершины ломаной по столбцам
+    qint32 emitPoints(qint32 columnCount);
+    // среднее время вызова, мкс
+    template <typename Func> double measure(Func func);
+};
+
+MinMaxBench::MinMaxBench()
+{
+    mSamples.resize(size_t(BENCH_SAMPLES));
+    unsigned int seed = 1;
+    double minValue = 0, maxValue = 0;
+    for (qint64 i = 0; i < BENCH_SAMPLES; i++) {
+        seed = seed * 1103515245 + 12345;
+        double phase = double(i % BENCH_EVENT_INTERVAL) / BENCH_EVENT_INTERVAL;
+        mSamples[i] = 100 * sin(2 * M_PI * phase) + 40 * exp(-50 * phase * phase) + double(seed >> 24) / 16;
+        if (i == 0 || minValue > mSamples[i]) minValue = mSamples[i];
+        if (i == 0 || maxValue < mSamples[i]) maxValue = mSamples[i];
+    }
+    mPyramid.build(mSamples.data(), BENCH_SAMPLES);
+    mMapping.meanValue = (maxValue + minValue) * 0.5;
+    mMapping.scale = BENCH_HEIGHT / (maxValue - minValue);
+    mMapping.startY = BENCH_HEIGHT / 2;
+    mMapping.height = BENCH_HEIGHT;
+    mColumns.resize(BENCH_COLUMNS);
+    mPoints.resize(BENCH_COLUMNS * 2);
+    mChecksum = 0;
+}
+
+qint32 MinMaxBench::runPerSample(qint64 beginSample, qint64 samplesCount)
+{
+    // как в paintEvent до пирамиды, но X в 64 битах (32-битное произведение переполнялось после 10^6 отсчетов)
+    QPoint * points = mPoints.data();
+    const double * pCurrentData = mSamples.data() + beginSample;
+    qint32 pointCount = 0;
+    qint32 xPrev = 0;
+    qint32 yMax = 0;
+    qint32 yMin = BENCH_HEIGHT;
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++, pCurrentData++) {
+        qint32 x = qint32(BENCH_COLUMNS * sampleIndex / samplesCount);
+        if (x < 0) x = 0;
+        if (x > BENCH_COLUMNS - 1) x = BENCH_COLUMNS - 1;
+
+        qint32 y = mMapping.startY - (*pCurrentData - mMapping.meanValue) * mMapping.scale;
+        if (y < 0) y = 0;
+        if (y > BENCH_HEIGHT - 1) y = BENCH_HEIGHT - 1;
+
+        if (yMin > y) yMin = y;
+        if (yMax < y) yMax = y;
+
+        if (x != xPrev) {
+            points[pointCount++] = QPoint(x, yMin);
+            if (yMin != yMax) {
+                points[pointCount++] = QPoint(x, yMax);
+            }
+            xPrev = x;
+            yMax = 0;
+            yMin = BENCH_HEIGHT;
+        }
+    }
+    return pointCount;
+}
+
+qint32 MinMaxBench::runKernel(double samplesPerPixel, bool avx2)
+{
+    qint32 columnCount;
+#if BENCH_HAVE_AVX2
+    if (avx2) {
+        columnCount = buildColumnsAvx2(mSamples.data(), BENCH_SAMPLES, samplesPerPixel, BENCH_COLUMNS / 2,
+                                       1, BENCH_COLUMNS, mMapping, mColumns.data());
+        return emitPoints(columnCount);
+    }
+#else
+    Q_UNUSED(avx2);
+#endif
+    columnCount = MinMaxPyramid::buildColumns(mSamples.data(), BENCH_SAMPLES, samplesPerPixel, BENCH_COLUMNS / 2,
+                                              1, BENCH_COLUMNS, mMapping, mColumns.data());
+    return emitPoints(columnCount);
+}
+
+qint32 MinMaxBench::runPyramid(double samplesPerPixel)
+{
+    int level = mPyramid.findLevel(samplesPerPixel);
+    if (level < 0) {
+        return runKernel(samplesPerPixel, false);
+    }
+    MinMaxPyramid::Column * columns = mColumns.data();
+    for (qint32 column = 0; column < BENCH_COLUMNS; column++) {
+        qint64 absX = BENCH_COLUMNS / 2 + column;
+        qint64 beginSample = qint64(double(absX) * samplesPerPixel);
+        qint64 endSample = qint64(double(absX + 1) * samplesPerPixel);
+        columns[column] = MinMaxPyramid::getColumn(mPyramid.getRange(level, beginSample, endSample, mSamples.data()), mMapping);
+    }
+    return emitPoints(BENCH_COLUMNS);
+}
+
+qint32 MinMaxBench::emitPoints(qint32 columnCount)
+{
+    QPoint * points = mPoints.data();
+    const MinMaxPyramid::Column * columns = mColumns.data();
+    qint32 pointCount = 0;
+    for (qint32 column = 0; column < columnCount; column++) {
+        if (columns[column].yTop == columns[column].yBottom) {
+            points[pointCount++] = QPoint(column, columns[column].yTop);
+        } else if (columns[column].falling) {
+            points[pointCount++] = QPoint(column, columns[column].yTop);
+            points[pointCount++] = QPoint(column, columns[column].yBottom);
+        } else {
+            points[pointCount++] = QPoint(column, columns[column].yBottom);
+            points[pointCount++] = QPoint(column, columns[column].yTop);
+        }
+    }
+    return pointCount;
+}
+
+template <typename Func> double MinMaxBench::measure(Func func)
+{
+    // первый вызов без замера, затем повторы не короче BENCH_MIN_TIME_NS
+    mChecksum += func();
+    QElapsedTimer timer;
+    timer.start();
+    qint64 repeats = 0;
+    do {
+        mChecksum += func();
+        repeats++;
+    } while (timer.nsecsElapsed() < BENCH_MIN_TIME_NS);
+    return double(timer.nsecsElapsed()) / 1000.0 / repeats;
+}
+
+void MinMaxBench::run()
+{
+    bool haveAvx2 = cpuHasAvx2();
+    printf("frame of %d columns, %lld samples in channel, AVX2 %s\n", BENCH_COLUMNS, BENCH_SAMPLES,
+           haveAvx2 ? "available" : "not available");
+    printf("samples/frame  level  per-sample, us  scalar, us  avx2, us  pyramid, us  same\n");
+    for (qint64 samplesCount = 1000; samplesCount <= 10000000; samplesCount *= 10) {
+        double samplesPerPixel = double(samplesCount) / BENCH_COLUMNS;
+        qint64 beginSample = qint64(double(BENCH_COLUMNS / 2) * samplesPerPixel);
+        double perSampleUs = measure([&]() { return runPerSample(beginSample, samplesCount); });
+        double scalarUs = measure([&]() { return runKernel(samplesPerPixel, false); });
+        QVector<MinMaxPyramid::Column> scalarColumns = mColumns;
+        double avx2Us = haveAvx2 ? measure([&]() { return runKernel(samplesPerPixel, true); }) : 0;
+        bool same = true;
+        for (qint32 column = 0; haveAvx2 && column < BENCH_COLUMNS; column++) {
+            same = same && scalarColumns[column].yTop == mColumns[column].yTop &&
+                    scalarColumns[column].yBottom == mColumns[column].yBottom &&
+                    scalarColumns[column].falling == mColumns[column].falling;
+        }
+        double pyramidUs = measure([&]() { return runPyramid(samplesPerPixel); });
+        printf("%13lld  %5d  %14.1f  %10.1f  %8.1f  %11.1f  %s\n", samplesCount, mPyramid.findLevel(samplesPerPixel),
+               perSampleUs, scalarUs, avx2Us, pyramidUs, same ? "yes" : "NO");
+    }
+    printf("checksum %lld\n", mChecksum);
+}
+
+int main()
+{
+    MinMaxBench bench;
+    bench.run();
+    return 0;
+}
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Замер прореживания кадра: поотсчетный цикл, столбцы buildColumns и их AVX2-вариант, пирамида
+#
+#-------------------------------------------------
+
+QT       += core
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = bench_minmax
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += bench_minmax.cpp \
+        $$SRC/minmaxpyramid.cpp
+
+HEADERS  += $$SRC/minmaxpyramid.h
+
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE *= -O2
@@ -0,0 +1,128 @@
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "peakdetector.h"
+
+// синтетический канал: BENCH_DURATION_H ч на BENCH_SAMPLE_RATE Гц
+#define BENCH_DURATION_H 24
+#define BENCH_SAMPLE_RATE 250
+// интервал между пиками, отсчетов (ЧСС 75)
+#define BENCH_EVENT_INTERVAL 200
+// повторов замера RollingStatistics (прежний цикл замеряется один раз)
+#define BENCH_REPEATS 5
+
+// замер нормализации перед поиском пиков по окну 60 / MIN_HEART_RATE с: прежний цикл из
+// GraphicAreaWidget::findHeartRate (копирование окна и просмотр всех его отсчетов на каждом отсчете)
+// и PeakDetector::normalize на RollingStatistics
+class RollingBench
+{
+public:
+    RollingBench();
+    void run();
+
+private:
+    //
+    std::vector<double> mSamples;
+    //
+    int mWindowSize;
+
+    // прежний цикл, возвращает количество отсчетов выше 0.5
+    qint64 normalizePerWindow(double * pNormSamples);
+};
+
+RollingBench::RollingBench()
+{
+    qint64 samplesCount = qint64(BENCH_DURATION_H) * 3600 * BENCH_SAMPLE_RATE;
+    mSamples.resize(size_t(samplesCount));
+    unsigned int seed = 1;
+    for (qint64 i = 0; i < samplesCount; i++) {
+        seed = seed * 1103515245 + 12345;
+        double phase = double(i % BENCH_EVENT_INTERVAL) / BENCH_EVENT_INTERVAL;
+        // пульсовая волна с медленным дрейфом базовой линии и шумом
+        mSamples[i] = 100 * sin(2 * M_PI * phase) + 40 * exp(-50 * phase * phase) +
+                50 * sin(2 * M_PI * double(i) / (600.0 * BENCH_SAMPLE_RATE)) + double(seed >> 24) / 16;
+    }
+    mWindowSize = int(BENCH_SAMPLE_RATE / (MIN_HEART_RATE / 60.));
+}
+
+qint64 RollingBench::normalizePerWindow(double * pNormSamples)
+{
+    // как в findHeartRate до RollingStatistics, но индексы в 64 битах
+    qint64 samplesCount = qint64(mSamples.size());
+    int windowSize = mWindowSize;
+    std::vector<double> window(size_t(windowSize), 0.0);
+    double * pWindow = window.data();
+    const double * pInData = mSamples.data();
+    double * pNormData = pNormSamples;
+    qint64 aboveMean = 0;
+    for (qint64 i = 0; i < samplesCount; i++, pInData++, pNormData++) {
+        if (i < samplesCount - windowSize) {
+            memcpy(pWindow, pInData, sizeof(double) * windowSize);
+        }
+        double minValue = 0.;
+        double maxValue = 0.;
+        for (int j = 0; j < windowSize; j++) {
+            if (j == 0 || minValue > *(pWindow + j)) minValue = *(pWindow + j);
+            if (j == 0 || maxValue < *(pWindow + j)) maxValue = *(pWindow + j);
+        }
+        if (maxValue == minValue) {
+            *pNormData = 0;
+        } else {
+            *pNormData = (*pInData - minValue) / (maxValue - minValue);
+        }
+        if (*pNormData > 0.5) aboveMean++;
+    }
+    return aboveMean;
+}
+
+void RollingBench::run()
+{
+    qint64 samplesCount = qint64(mSamples.size());
+    printf("%d h at %d Hz, %lld samples, window %d samples\n", BENCH_DURATION_H, BENCH_SAMPLE_RATE,
+           samplesCount, mWindowSize);
+
+    std::vector<double> normOld(mSamples.size());
+    QElapsedTimer timer;
+    timer.start();
+    qint64 aboveMeanOld = normalizePerWindow(normOld.data());
+    double perWindowMs = double(timer.nsecsElapsed()) / 1e6;
+
+    // весь массив одной частью, как при поиске в одном потоке
+    PeakDetector::Task task;
+    task.pInSamples = mSamples.data();
+    task.pHeartRate = nullptr;
+    task.samplesCount = samplesCount;
+    task.sampleRate = BENCH_SAMPLE_RATE;
+    task.inversion = 0;
+    PeakDetector::Pass pass;
+    pass.windowSize = mWindowSize;
+    pass.minInterval = 0;
+    pass.inverted = false;
+    pass.normSamples.resize(mSamples.size());
+    PeakDetector::Chunk chunk;
+    chunk.task = 0;
+    chunk.beginIndex = 0;
+    chunk.endIndex = samplesCount;
+    chunk.aboveMean = 0;
+    qint64 rollingNs = 0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        timer.start();
+        PeakDetector::normalize(task, pass, chunk);
+        rollingNs += timer.nsecsElapsed();
+    }
+    double rollingMs = double(rollingNs) / 1e6 / BENCH_REPEATS;
+    bool same = chunk.aboveMean == aboveMeanOld &&
+            memcmp(normOld.data(), pass.normSamples.data(), sizeof(double) * normOld.size()) == 0;
+
+    printf("per-window, ms  rolling, ms  speedup  same\n");
+    printf("%14.1f  %11.1f  %7.1f  %s\n", perWindowMs, rollingMs, perWindowMs / rollingMs, same ? "yes" : "NO");
+}
+
+int main()
+{
+    RollingBench bench;
+    bench.run();
+    return 0;
+}
@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Замер нормализации перед поиском пиков: копирование и просмотр окна и RollingStatistics
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = bench_rolling
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += bench_rolling.cpp \
+        $$SRC/peakdetector.cpp \
+        $$SRC/rollingstatistics.cpp
+
+HEADERS  += $$SRC/peakdetector.h \
+    $$SRC/rollingstatistics.h
+
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE *= -O2
@@ -0,0 +1,270 @@
+#include <QElapsedTimer>
+#include <QVector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <new>
+#include <vector>
+#include "waveformrenderer.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+// синтетическая запись: BENCH_CHANNELS каналов по BENCH_DURATION_S с на BENCH_SAMPLE_RATE Гц
+#define BENCH_CHANNELS 8
+#define BENCH_DURATION_S 3600
+#define BENCH_SAMPLE_RATE 250
+// интервал между событиями (пиками) канала, отсчетов
+#define BENCH_EVENT_INTERVAL 200
+// размер кадра, пикс
+#define BENCH_FRAME_WIDTH 1280
+#define BENCH_FRAME_HEIGHT 480
+// кэш плиток меньше прокручиваемого участка, чтобы замер шел с вытеснением, КБ
+#define BENCH_TILE_CACHE_KB (8 * 1024)
+// кадров прогрева (кэши и буферы достигают рабочего размера) и замера; сдвиг на 1 пикс за кадр
+#define BENCH_WARMUP_FRAMES 1000
+#define BENCH_FRAMES 10000
+
+// счетчики выделений памяти: на glibc перехватывается malloc (через него идут и operator new, и контейнеры Qt),
+// на остальных платформах - только operator new
+static std::atomic<qint64> gAllocCount(0);
+static std::atomic<qint64> gLiveCount(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * p, size_t size);
+void __libc_free(void * p);
+
+void * malloc(size_t size)
+{
+    gAllocCount++;
+    gLiveCount++;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+    gAllocCount++;
+    gLiveCount++;
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void * p, size_t size)
+{
+    gAllocCount++;
+    if (p == nullptr) {
+        gLiveCount++;
+    }
+    return __libc_realloc(p, size);
+}
+
+void free(void * p)
+{
+    if (p != nullptr) {
+        gLiveCount--;
+    }
+    __libc_free(p);
+}
+}
+#else
+void * operator new(size_t size)
+{
+    gAllocCount++;
+    gLiveCount++;
+    void * p = malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void * p) noexcept
+{
+    if (p != nullptr) {
+        gLiveCount--;
+    }
+    free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void * p, size_t) noexcept
+{
+    operator delete(p);
+}
+#endif
+
+// резидентная память процесса, КБ (0 если платформа не поддерживается)
+static qint64 getResidentKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize / 1024);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    FILE * pFile = fopen("/proc/self/statm", "r");
+    if (pFile == nullptr) {
+        return 0;
+    }
+    long long totalPages = 0, residentPages = 0;
+    if (fscanf(pFile, "%lld %lld", &totalPages, &residentPages) != 2) {
+        residentPages = 0;
+    }
+    fclose(pFile);
+    return qint64(residentPages) * sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return 0;
+#endif
+}
+
+// прокрутка WaveformRenderer::renderFrame со сдвигом startPixel на 1 пикс за кадр:
+// выделения памяти на кадр и рост резидентной памяти после прогрева
+class SoakBench
+{
+public:
+    SoakBench();
+    void run();
+
+private:
+    //
+    edf_hdr_struct mEDFHeader;
+    //
+    QVector<ChannelParams> mChannels;
+    //
+    WaveformRenderer mRenderer;
+    //
+    ViewParams mView;
+    // кадров с выделениями памяти и наибольшее число выделений за кадр
+    qint64 mAllocFrames;
+    qint64 mMaxFrameAllocs;
+    // контрольная сумма кадров, чтобы компилятор не выбросил отрисовку
+    qint64 mChecksum;
+
+    // frameCount кадров начиная с mView.startPixel
+    void scroll(int frameCount);
+};
+
+SoakBench::SoakBench()
+{
+    memset(&mEDFHeader, 0, sizeof(mEDFHeader));
+    mEDFHeader.edfsignals = BENCH_CHANNELS;
+    mEDFHeader.datarecord_duration = EDFLIB_TIME_DIMENSION;
+    mChannels.resize(BENCH_CHANNELS);
+    qint64 samplesCount = qint64(BENCH_DURATION_S) * BENCH_SAMPLE_RATE;
+    for (int channel = 0; channel < BENCH_CHANNELS; channel++) {
+        edf_param_struct & param = mEDFHeader.signalparam[channel];
+        param.smp_in_datarecord = BENCH_SAMPLE_RATE;
+        param.smp_in_file = samplesCount;
+        param.phys_max = 1000;
+        param.phys_min = -1000;
+        param.dig_max = 32767;
+        param.dig_min = -32768;
+
+        // пульсовая волна с шумом, фаза зависит от канала
+        std::vector<double> samples(size_t(samplesCount), 0);
+        unsigned int seed = 1 + channel;
+        for (qint64 i = 0; i < samplesCount; i++) {
+            seed = seed * 1103515245 + 12345;
+            double phase = double(i % BENCH_EVENT_INTERVAL) / BENCH_EVENT_INTERVAL + channel * 0.05;
+            samples[i] = 100 * sin(2 * M_PI * phase) + 40 * exp(-50 * phase * phase) + double(seed >> 24) / 16;
+        }
+        ChannelParams & params = mChannels[channel];
+        params.setSamples(quint32(channel), std::move(samples));
+        // события с ЧСС и префиксными суммами (маркеры при подробной развертке)
+        for (qint64 i = BENCH_EVENT_INTERVAL / 2; i < samplesCount; i += BENCH_EVENT_INTERVAL) {
+            params.events.push_back(i);
+            params.eventRateCounts.push_back(params.eventRateCounts.back() + 1);
+            params.eventRateSums.push_back(params.eventRateSums.back() + 60 * BENCH_SAMPLE_RATE / BENCH_EVENT_INTERVAL);
+        }
+    }
+    mRenderer.setData(&mEDFHeader, &mChannels);
+    mRenderer.setTileCacheSize(BENCH_TILE_CACHE_KB);
+
+    mView.generation = 1;
+    mView.contentGeneration = 1;
+    mView.size = QSize(BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT);
+    mView.startPixel = 0;
+    mView.scalingFactors = QVector<qreal>(BENCH_CHANNELS, 1.0);
+    mView.showStats = false;
+    mView.frameBudgetMs = 0;
+    mAllocFrames = 0;
+    mMaxFrameAllocs = 0;
+    mChecksum = 0;
+}
+
+void SoakBench::scroll(int frameCount)
+{
+    for (int frame = 0; frame < frameCount; frame++) {
+        qint64 allocsBefore = gAllocCount;
+        {
+            // кадр не удерживается между вызовами, иначе следующий renderFrame копирует изображение при сдвиге
+            QImage image = mRenderer.renderFrame(mView);
+            mChecksum += image.width();
+        }
+        qint64 frameAllocs = gAllocCount - allocsBefore;
+        if (frameAllocs > 0) {
+            mAllocFrames++;
+        }
+        if (mMaxFrameAllocs < frameAllocs) {
+            mMaxFrameAllocs = frameAllocs;
+        }
+        mView.generation++;
+        mView.startPixel++;
+    }
+}
+
+void SoakBench::run()
+{
+    printf("%d channels, %dx%d frame, %.1f samples/px, tile cache %d KB\n", BENCH_CHANNELS, BENCH_FRAME_WIDTH,
+           BENCH_FRAME_HEIGHT, WaveformRenderer::getSamplesPerPixel(&mEDFHeader, 0, mView.sweepFactor), BENCH_TILE_CACHE_KB);
+
+    scroll(BENCH_WARMUP_FRAMES);
+    mAllocFrames = 0;
+    mMaxFrameAllocs = 0;
+
+    qint64 residentBeforeKb = getResidentKb();
+    qint64 allocsBefore = gAllocCount;
+    qint64 liveBefore = gLiveCount;
+    QElapsedTimer timer;
+    timer.start();
+    scroll(BENCH_FRAMES);
+    double frameUs = double(timer.nsecsElapsed()) / 1000.0 / BENCH_FRAMES;
+    qint64 allocs = gAllocCount - allocsBefore;
+    qint64 liveDelta = gLiveCount - liveBefore;
+    qint64 residentAfterKb = getResidentKb();
+
+    printf("frames  allocs  allocs/frame  frames with allocs  max/frame  live blocks delta  RSS before, KB  RSS after, KB  frame, us\n");
+    printf("%6d  %6lld  %12.2f  %18lld  %9lld  %17lld  %14lld  %13lld  %9.1f\n", BENCH_FRAMES, allocs,
+           double(allocs) / BENCH_FRAMES, mAllocFrames, mMaxFrameAllocs, liveDelta, residentBeforeKb, residentAfterKb, frameUs);
+    printf("checksum %lld\n", mChecksum);
+}
+
+int main()
+{
+    SoakBench bench;
+    bench.run();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# Длительная прокрутка WaveformRenderer: выделения памяти и RSS
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = bench_soak
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += bench_soak.cpp \
+        $$SRC/channelparams.cpp \
+        $$SRC/minmaxpyramid.cpp \
+        $$SRC/pressurestats.cpp \
+        $$SRC/timeaxismapper.cpp \
+        $$SRC/waveformrenderer.cpp
+
+HEADERS  += $$SRC/channelparams.h \
+    $$SRC/minmaxpyramid.h \
+    $$SRC/pressurestats.h \
+    $$SRC/timeaxismapper.h \
+    $$SRC/waveformrenderer.h
+
+win32: LIBS += -lpsapi
+
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE *= -O2
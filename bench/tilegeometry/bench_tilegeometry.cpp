@@ -0,0 +1,144 @@
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QVector>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "waveformrenderer.h"
+
+// синтетическая запись: BENCH_MAX_CHANNELS каналов по BENCH_DURATION_S с на BENCH_SAMPLE_RATE Гц
+#define BENCH_MAX_CHANNELS 16
+#define BENCH_DURATION_S 3600
+#define BENCH_SAMPLE_RATE 250
+// интервал между событиями (пиками) канала, отсчетов
+#define BENCH_EVENT_INTERVAL 200
+// ширина плитки, пикс (TILE_WIDTH в waveformrenderer.cpp) и плиток на канал в кадре
+#define BENCH_TILE_WIDTH 256
+#define BENCH_TILES 8
+// высота полосы канала, пикс
+#define BENCH_CHANNEL_HEIGHT 60
+// повторов замера
+#define BENCH_REPEATS 200
+
+// замер WaveformRenderer::computeTileGeometry для всех плиток кадра: последовательно по плиткам
+// (как до распараллеливания) и по каналам в пуле потоков
+class TileGeometryBench
+{
+public:
+    TileGeometryBench();
+    void run();
+
+private:
+    //
+    edf_hdr_struct mEDFHeader;
+    //
+    QVector<ChannelParams> mChannels;
+    //
+    WaveformRenderer mRenderer;
+    // время подготовки геометрии кадра из channelCount каналов, мкс
+    double measure(int channelCount, qreal sweepFactor, bool parallel);
+};
+
+TileGeometryBench::TileGeometryBench()
+{
+    memset(&mEDFHeader, 0, sizeof(mEDFHeader));
+    mEDFHeader.edfsignals = BENCH_MAX_CHANNELS;
+    mEDFHeader.datarecord_duration = EDFLIB_TIME_DIMENSION;
+    mChannels.resize(BENCH_MAX_CHANNELS);
+    qint64 samplesCount = qint64(BENCH_DURATION_S) * BENCH_SAMPLE_RATE;
+    for (int channel = 0; channel < BENCH_MAX_CHANNELS; channel++) {
+        edf_param_struct & param = mEDFHeader.signalparam[channel];
+        param.smp_in_datarecord = BENCH_SAMPLE_RATE;
+        param.smp_in_file = samplesCount;
+        param.phys_max = 1000;
+        param.phys_min = -1000;
+        param.dig_max = 32767;
+        param.dig_min = -32768;
+
+        // пульсовая волна с шумом, фаза зависит от канала
+        std::vector<double> samples(size_t(samplesCount), 0);
+        unsigned int seed = 1 + channel;
+        for (qint64 i = 0; i < samplesCount; i++) {
+            seed = seed * 1103515245 + 12345;
+            double phase = double(i % BENCH_EVENT_INTERVAL) / BENCH_EVENT_INTERVAL + channel * 0.05;
+            samples[i] = 100 * sin(2 * M_PI * phase) + 40 * exp(-50 * phase * phase) + double(seed >> 24) / 16;
+        }
+        ChannelParams & params = mChannels[channel];
+        params.setSamples(quint32(channel), std::move(samples));
+        // события с ЧСС и префиксными суммами (маркеры при подробной развертке, полосы при сжатой)
+        for (qint64 i = BENCH_EVENT_INTERVAL / 2; i < samplesCount; i += BENCH_EVENT_INTERVAL) {
+            params.events.push_back(i);
+            params.eventRateCounts.push_back(params.eventRateCounts.back() + 1);
+            params.eventRateSums.push_back(params.eventRateSums.back() + 60 * BENCH_SAMPLE_RATE / BENCH_EVENT_INTERVAL);
+        }
+    }
+    mRenderer.setData(&mEDFHeader, &mChannels);
+    mRenderer.mView.scalingFactors = QVector<qreal>(BENCH_MAX_CHANNELS, 1.0);
+}
+
+double TileGeometryBench::measure(int channelCount, qreal sweepFactor, bool parallel)
+{
+    mRenderer.mView.sweepFactor = sweepFactor;
+    // кадр в середине записи
+    qint64 firstTile = qint64(double(mEDFHeader.signalparam[0].smp_in_file / 2) /
+            WaveformRenderer::getSamplesPerPixel(&mEDFHeader, 0, sweepFactor)) / BENCH_TILE_WIDTH;
+    QVector<ChannelTiles> jobs;
+    qint32 slotCount = 0;
+    for (int channel = 0; channel < channelCount; channel++) {
+        ChannelTiles job;
+        job.firstSlot = slotCount;
+        job.slotCount = BENCH_TILES;
+        for (int tile = 0; tile < BENCH_TILES; tile++) {
+            if (mRenderer.mTileGeometry.size() <= slotCount) {
+                mRenderer.mTileGeometry.resize(slotCount + 1);
+            }
+            TileGeometry & geometry = mRenderer.mTileGeometry[slotCount++];
+            geometry.channel = channel;
+            geometry.tileIndex = firstTile + tile;
+            geometry.channelHeight = BENCH_CHANNEL_HEIGHT;
+            geometry.coarse = false;
+        }
+        jobs.append(job);
+    }
+
+    QElapsedTimer timer;
+    // первый проход без замера (буферы геометрии достигают нужного размера)
+    for (int repeat = -1; repeat < BENCH_REPEATS; repeat++) {
+        if (repeat == 0) {
+            timer.start();
+        }
+        if (parallel) {
+            mRenderer.computeTileGeometry(jobs);
+        } else {
+            for (qint32 slot = 0; slot < slotCount; slot++) {
+                mRenderer.computeTileGeometry(mRenderer.mTileGeometry[slot]);
+            }
+        }
+    }
+    return double(timer.nsecsElapsed()) / 1000.0 / BENCH_REPEATS;
+}
+
+void TileGeometryBench::run()
+{
+    int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+    printf("computeTileGeometry, %d tiles per channel, %d threads in pool\n", BENCH_TILES, threadCount);
+    printf("channels  samples/px  serial, us  pool, us  speedup\n");
+    const int channelCounts[] = { 1, 4, 16 };
+    const qreal sweepFactors[] = { 30.0, 1.0, 0.03 };
+    for (qreal sweepFactor : sweepFactors) {
+        for (int channelCount : channelCounts) {
+            double serialUs = measure(channelCount, sweepFactor, false);
+            double parallelUs = measure(channelCount, sweepFactor, true);
+            printf("%8d  %10.1f  %10.1f  %8.1f  %7.2f\n", channelCount,
+                   WaveformRenderer::getSamplesPerPixel(&mEDFHeader, 0, sweepFactor), serialUs, parallelUs, serialUs / parallelUs);
+        }
+    }
+}
+
+int main()
+{
+    TileGeometryBench bench;
+    bench.run();
+    return 0;
+}
@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# Замер подготовки геометрии плиток по каналам в пуле потоков
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = bench_tilegeometry
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += bench_tilegeometry.cpp \
+        $$SRC/channelparams.cpp \
+        $$SRC/minmaxpyramid.cpp \
+        $$SRC/pressurestats.cpp \
+        $$SRC/timeaxismapper.cpp \
+        $$SRC/waveformrenderer.cpp
+
+HEADERS  += $$SRC/channelparams.h \
+    $$SRC/minmaxpyramid.h \
+    $$SRC/pressurestats.h \
+    $$SRC/timeaxismapper.h \
+    $$SRC/waveformrenderer.h
+
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE *= -O2
@@ -0,0 +1,138 @@
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "peakdetector.h"
+#include "sampleindexmap.h"
+#include "timelagmatcher.h"
+
+// частоты каналов ЭКГ и плетизмограммы, Гц
+#define BENCH_RATE_ECG 500
+#define BENCH_RATE_P 125
+// ЧСС синтетической записи колеблется в [BENCH_HEART_RATE_MIN, BENCH_HEART_RATE_MAX]
+#define BENCH_HEART_RATE_MIN 55
+#define BENCH_HEART_RATE_MAX 95
+// задержка пульсовой волны в [BENCH_LAG_MIN_S, BENCH_LAG_MAX_S], с
+#define BENCH_LAG_MIN_S 0.18
+#define BENCH_LAG_MAX_S 0.32
+// повторов замера TimeLagMatcher (поотсчетный поиск замеряется один раз)
+#define BENCH_REPEATS 5
+
+// синтетическая запись: пики ЭКГ и плетизмограммы в массивах ЧСС, как после поиска пиков
+struct PeakTrains {
+    std::vector<int> heartRateECG;
+    std::vector<int> heartRateP;
+    std::vector<double> samplesP;
+};
+
+// поиск из GraphicAreaWidget::findTimeLag до TimeLagMatcher: от каждого R-зубца вперед по отсчетам
+// плетизмограммы до первого пика с задержкой в (0, maxTimeLag)
+static void findTimeLagPerSample(const int * pHeartRateECG, qint64 samplesCountECG, double sampleRateECG,
+                                 const int * pHeartRateP, double * pTimeLag, qint64 samplesCountP, double sampleRateP,
+                                 const SampleIndexMap & indexMapECGToP)
+{
+    int maxTimeLag = 60.0 / MIN_HEART_RATE;
+
+    memset(pTimeLag, 0, sizeof(double) * samplesCountP);
+
+    for (qint64 indexECG = 0; indexECG < samplesCountECG; indexECG++) {
+        double timeECG = double(indexECG) / sampleRateECG;
+        if (*(pHeartRateECG + indexECG) > 0) {
+            qint64 startIndexP = indexMapECGToP.map(indexECG);
+            for (qint64 indexP = startIndexP; indexP < samplesCountP; indexP++) {
+                double timeP = double(indexP) / sampleRateP;
+                if (timeP - timeECG > 0 && timeP - timeECG < maxTimeLag && *(pHeartRateP + indexP) > 0) {
+                    *(pTimeLag + indexP) = timeP - timeECG;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// запись длительностью durationH ч, пики плетизмограммы пропадают на dropoutH ч в середине записи
+static PeakTrains makePeakTrains(double durationH, double dropoutH)
+{
+    PeakTrains trains;
+    qint64 samplesCountECG = qint64(durationH * 3600 * BENCH_RATE_ECG);
+    qint64 samplesCountP = qint64(durationH * 3600 * BENCH_RATE_P);
+    trains.heartRateECG.assign(size_t(samplesCountECG), 0);
+    trains.heartRateP.assign(size_t(samplesCountP), 0);
+    trains.samplesP.assign(size_t(samplesCountP), 0);
+    double dropoutBeginS = (durationH - dropoutH) * 3600 / 2;
+    double dropoutEndS = dropoutBeginS + dropoutH * 3600;
+
+    unsigned int seed = 1;
+    double heartRate = (BENCH_HEART_RATE_MIN + BENCH_HEART_RATE_MAX) / 2;
+    for (double timeS = 1.0; ; ) {
+        seed = seed * 1103515245 + 12345;
+        double random = double(seed >> 8) / double(1 << 24);
+        qint64 indexECG = qint64(timeS * BENCH_RATE_ECG);
+        double timeP = timeS + BENCH_LAG_MIN_S + (BENCH_LAG_MAX_S - BENCH_LAG_MIN_S) * random;
+        qint64 indexP = qint64(timeP * BENCH_RATE_P);
+        if (indexECG >= samplesCountECG || indexP >= samplesCountP) {
+            break;
+        }
+        trains.heartRateECG[indexECG] = int(heartRate);
+        if (timeP < dropoutBeginS || timeP >= dropoutEndS) {
+            trains.heartRateP[indexP] = int(heartRate);
+            trains.samplesP[indexP] = 1;
+        }
+        // медленный дрейф ЧСС в пределах диапазона
+        heartRate += (random - 0.5) * 2;
+        heartRate = qBound(double(BENCH_HEART_RATE_MIN), heartRate, double(BENCH_HEART_RATE_MAX));
+        timeS += 60.0 / heartRate;
+    }
+    return trains;
+}
+
+static void runCase(double durationH, double dropoutH)
+{
+    PeakTrains trains = makePeakTrains(durationH, dropoutH);
+    qint64 samplesCountECG = qint64(trains.heartRateECG.size());
+    qint64 samplesCountP = qint64(trains.heartRateP.size());
+    std::vector<double> timeLagOld(trains.samplesP.size());
+    std::vector<double> timeLagNew(trains.samplesP.size());
+
+    QElapsedTimer timer;
+    timer.start();
+    findTimeLagPerSample(trains.heartRateECG.data(), samplesCountECG, BENCH_RATE_ECG,
+                         trains.heartRateP.data(), timeLagOld.data(), samplesCountP, BENCH_RATE_P,
+                         SampleIndexMap(BENCH_RATE_ECG, BENCH_RATE_P));
+    double perSampleMs = double(timer.nsecsElapsed()) / 1e6;
+
+    // как в AnalysisThread: списки пиков из массивов ЧСС и сопоставление
+    TimeLagMatcher matcher;
+    size_t peakCountECG = 0, peakCountP = 0;
+    qint64 extractNs = 0, matchNs = 0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        timer.start();
+        std::vector<qint64> peaksECG = TimeLagMatcher::extractPeaks(trains.heartRateECG.data(), samplesCountECG);
+        std::vector<qint64> peaksP = TimeLagMatcher::extractPeaks(trains.heartRateP.data(), samplesCountP);
+        extractNs += timer.nsecsElapsed();
+        timer.start();
+        matcher.match(peaksECG, BENCH_RATE_ECG, peaksP, trains.samplesP.data(), BENCH_RATE_P,
+                      timeLagNew.data(), samplesCountP);
+        matchNs += timer.nsecsElapsed();
+        peakCountECG = peaksECG.size();
+        peakCountP = peaksP.size();
+    }
+    double extractMs = double(extractNs) / 1e6 / BENCH_REPEATS;
+    double matchMs = double(matchNs) / 1e6 / BENCH_REPEATS;
+    bool same = memcmp(timeLagOld.data(), timeLagNew.data(), sizeof(double) * timeLagOld.size()) == 0;
+
+    printf("%11.0f  %10.0f  %9zu  %11zu  %14.1f  %11.1f  %9.2f  %7.1f  %s\n", durationH, dropoutH, peakCountECG, peakCountP,
+           perSampleMs, extractMs, matchMs, perSampleMs / (extractMs + matchMs), same ? "yes" : "NO");
+}
+
+int main()
+{
+    printf("ECG %d Hz, pleth %d Hz, heart rate %d..%d, lag %.2f..%.2f s\n", BENCH_RATE_ECG, BENCH_RATE_P,
+           BENCH_HEART_RATE_MIN, BENCH_HEART_RATE_MAX, BENCH_LAG_MIN_S, BENCH_LAG_MAX_S);
+    printf("duration, h  dropout, h  ECG peaks  pleth peaks  per-sample, ms  extract, ms  match, ms  speedup  same\n");
+    runCase(24, 0);
+    runCase(24, 1);
+    runCase(48, 0);
+    runCase(48, 1);
+    return 0;
+}
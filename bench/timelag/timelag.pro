@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Замер сопоставления R-зубцов и пульсовых волн: поотсчетный поиск и TimeLagMatcher
+#
+#-------------------------------------------------
+
+QT       += core
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = bench_timelag
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += bench_timelag.cpp \
+        $$SRC/sampleindexmap.cpp \
+        $$SRC/timelagmatcher.cpp
+
+HEADERS  += $$SRC/sampleindexmap.h \
+    $$SRC/timelagmatcher.h
+
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE *= -O2
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,14 +14,44 @@ TEMPLATE = app
 
 SOURCES += main.cpp\
         EDFlib/edflib.c \
+        analysisthread.cpp \
+        channelparams.cpp \
+        edfreader.cpp \
+        framerenderthread.cpp \
         graphicareawidget.cpp \
         leastsquaremethod.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        minmaxpyramid.cpp \
+        overviewwidget.cpp \
+        peakdetector.cpp \
+        pressurestats.cpp \
+        qrsdetector.cpp \
+        rollingstatistics.cpp \
+        sampleindexmap.cpp \
+        stripexporter.cpp \
+        timeaxismapper.cpp \
+        timelagmatcher.cpp \
+        waveformrenderer.cpp
 
 HEADERS  += mainwindow.h \
     EDFlib/edflib.h \
+    analysisthread.h \
+    channelparams.h \
+    edfreader.h \
+    framerenderthread.h \
     graphicareawidget.h \
-    leastsquaremethod.h
+    leastsquaremethod.h \
+    minmaxpyramid.h \
+    overviewwidget.h \
+    peakdetector.h \
+    pressurestats.h \
+    qrsdetector.h \
+    rollingstatistics.h \
+    sampleindexmap.h \
+    stripexporter.h \
+    timeaxismapper.h \
+    timelagmatcher.h \
+    waveformrenderer.h
 
 FORMS    += mainwindow.ui
 
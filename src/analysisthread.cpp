@@ -0,0 +1,613 @@
+#include "analysisthread.h"
+#include "leastsquaremethod.h"
+#include "qrsdetector.h"
+#include "waveformrenderer.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// размер блока отсчетов для потокового детектора QRS
+#define QRS_BLOCK_SAMPLES 65536
+
+AnalysisThread::AnalysisThread(QObject * parent) : QThread(parent)
+{
+    mHasRequest = false;
+    mBusy = false;
+    mHasResult = false;
+    mPublishing = false;
+    mStopping = false;
+    mpEDFHeader = nullptr;
+    mDetectedChannelECG = -1;
+    mDetectedChannelP = -1;
+    mDetectedChannelABP = -1;
+    mDetectedGeneration = 0;
+}
+
+AnalysisThread::~AnalysisThread()
+{
+    stop();
+}
+
+void AnalysisThread::setEDFHeader(const edf_hdr_struct * pEDFHeader)
+{
+    // поток расчета в это время свободен (см. cancel), найденные пики устарели
+    QMutexLocker locker(&mMutex);
+    mpEDFHeader = pEDFHeader;
+    mDetectedGeneration = 0;
+    mDetectedChannels.clear();
+    mCalibrationEvents.clear();
+}
+
+void AnalysisThread::requestAnalysis(const AnalysisParams & params)
+{
+    QMutexLocker locker(&mMutex);
+    // незапущенный запрос с поиском пиков для тех же каналов не теряется при замене пересчетом калибровки
+    bool keepDetection = mHasRequest && !mRequest.calibrationOnly && isSameDetection(mRequest, params);
+    mRequest = params;
+    mRequest.calibrationOnly = mRequest.calibrationOnly && !keepDetection;
+    mHasRequest = true;
+    // идущему расчету нужны другие пики: его результат устарел
+    if (mBusy && !isSameDetection(mRunning, params)) {
+        mCanceled.storeRelease(1);
+        mHasResult = false;
+    }
+    mCondition.wakeAll();
+}
+
+void AnalysisThread::cancel()
+{
+    QMutexLocker locker(&mMutex);
+    // отброшенный запрос не удерживает буферы отсчетов
+    mRequest = AnalysisParams();
+    mHasRequest = false;
+    mHasResult = false;
+    mCanceled.storeRelease(1);
+    mCondition.wakeAll();
+    while (mBusy) {
+        mIdleCondition.wait(&mMutex);
+    }
+}
+
+bool AnalysisThread::takeResult(AnalysisResult & result)
+{
+    QMutexLocker locker(&mMutex);
+    if (!mHasResult) {
+        return false;
+    }
+    std::swap(result, mResult);
+    mResult = AnalysisResult();
+    mHasResult = false;
+    mPublishing = true;
+    return true;
+}
+
+void AnalysisThread::releaseResult()
+{
+    QMutexLocker locker(&mMutex);
+    mPublishing = false;
+    mCondition.wakeAll();
+}
+
+void AnalysisThread::stop()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mStopping = true;
+        mCanceled.storeRelease(1);
+        mCondition.wakeAll();
+    }
+    wait();
+}
+
+bool AnalysisThread::isCanceled() const
+{
+    return mCanceled.loadAcquire() != 0;
+}
+
+void AnalysisThread::run()
+{
+    for (;;) {
+        AnalysisParams params;
+        {
+            QMutexLocker locker(&mMutex);
+            while (!mHasRequest && !mStopping) {
+                mCondition.wait(&mMutex);
+            }
+            if (mStopping) {
+                return;
+            }
+            // берется только последний запрос, промежуточные отбрасываются
+            std::swap(params, mRequest);
+            mHasRequest = false;
+            mRunning = params;
+            mBusy = true;
+            mCanceled.storeRelease(0);
+        }
+
+        // расчет идет без блокировки данных каналов: отсчеты в буферах запроса не изменяются
+        AnalysisResult result;
+        bool done = analyze(params, result);
+
+        QMutexLocker locker(&mMutex);
+        if (done && !isCanceled() && !mStopping) {
+            std::swap(mResult, result);
+            mHasResult = true;
+            locker.unlock();
+            emit analysisReady(params.generation);
+            locker.relock();
+            // следующий запрос начинается после записи результата в каналы потоком интерфейса
+            // (результат в mResult не заменяется до того, как его заберут)
+            while ((mHasResult || mPublishing) && !mStopping) {
+                mCondition.wait(&mMutex);
+            }
+        }
+        mRunning = AnalysisParams();
+        mBusy = false;
+        mIdleCondition.wakeAll();
+    }
+}
+
+bool AnalysisThread::isSameDetection(const AnalysisParams & params, const AnalysisParams & other)
+{
+    return params.inputGeneration == other.inputGeneration &&
+           params.channelECG == other.channelECG &&
+           params.channelP == other.channelP &&
+           params.channelABP == other.channelABP;
+}
+
+bool AnalysisThread::isDetectionValid(const AnalysisParams & params) const
+{
+    return mDetectedGeneration != 0 &&
+           mDetectedGeneration == params.inputGeneration &&
+           mDetectedChannelECG == params.channelECG &&
+           mDetectedChannelP == params.channelP &&
+           mDetectedChannelABP == params.channelABP;
+}
+
+bool AnalysisThread::analyze(const AnalysisParams & params, AnalysisResult & result)
+{
+    if (mpEDFHeader == nullptr) {
+        return false;
+    }
+    int channelsCount = qMin(int(params.samples.size()), mpEDFHeader->edfsignals);
+    if (params.channelECG < 0 || params.channelECG >= channelsCount ||
+        params.channelP < 0 || params.channelP >= channelsCount ||
+        params.channelABP < 0 || params.channelABP >= channelsCount) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    // пики и задержки ищутся только при изменении каналов или входных данных
+    bool detected = !isDetectionValid(params);
+    if (detected) {
+        if (params.calibrationOnly || !detect(params)) {
+            return false;
+        }
+    }
+    calibrate(params, result);
+    printf("Analysis: %s, %lld ms\n", detected ? "detection and calibration" : "calibration only", timer.elapsed());
+    return !isCanceled();
+}
+
+bool AnalysisThread::detect(const AnalysisParams & params)
+{
+    mDetectedGeneration = 0;
+    mDetectedChannels.clear();
+    mCalibrationEvents.clear();
+    emit progress(params.generation, ANALYSIS_STAGE_DETECTION, 0);
+
+    int channelECG = params.channelECG;
+    int channelP = params.channelP;
+    int channelABP = params.channelABP;
+
+    // рабочие массивы результатов по каналам (выделяются только записываемые, пустой массив - нули)
+    size_t channelsCount = params.samples.size();
+    std::vector<std::vector<int>> heartRate(channelsCount);
+    std::vector<std::vector<double>> timeLag(channelsCount);
+    std::vector<std::vector<double>> maximums(channelsCount);
+    std::vector<std::vector<double>> minimums(channelsCount);
+
+    // поиск пиков: каналы и части длинных каналов обрабатываются параллельно;
+    // пики максимумов и минимумов АД ищутся во временных массивах (ЧСС канала АД после расчета обнуляется),
+    // при совпадении каналов ЭКГ и плетизмограммы остается результат плетизмограммы
+    qint64 samplesCount = params.getSamplesCount(channelABP);
+    std::vector<int> heartRateABPMax(size_t(samplesCount), 0);
+    std::vector<int> heartRateABPMin(size_t(samplesCount), 0);
+    bool detectECG = channelECG != channelP;
+    if (detectECG) {
+        heartRate[channelECG].assign(size_t(params.getSamplesCount(channelECG)), 0);
+    }
+    heartRate[channelP].assign(size_t(params.getSamplesCount(channelP)), 0);
+    timeLag[channelP].assign(size_t(params.getSamplesCount(channelP)), 0);
+    maximums[channelABP].assign(size_t(samplesCount), 0);
+    minimums[channelABP].assign(size_t(samplesCount), 0);
+
+    QVector<PeakDetector::Task> tasks;
+    if (detectECG && params.ecgDetector != ECG_DETECTOR_QRS) {
+        tasks.append(getPeakDetectorTask(params, channelECG, heartRate[channelECG].data(), 1));
+    }
+    tasks.append(getPeakDetectorTask(params, channelP, heartRate[channelP].data(), 1));
+    tasks.append(getPeakDetectorTask(params, channelABP, heartRateABPMax.data(), 1));
+    tasks.append(getPeakDetectorTask(params, channelABP, heartRateABPMin.data(), -1));
+
+    // потоковый детектор QRS работает одновременно с остальными
+    QFuture<void> qrsFuture;
+    if (detectECG && params.ecgDetector == ECG_DETECTOR_QRS) {
+        const double * pSamplesECG = params.getSamples(channelECG);
+        int * pHeartRateECG = heartRate[channelECG].data();
+        qint64 samplesCountECG = params.getSamplesCount(channelECG);
+        double sampleRateECG = getSampleRate(channelECG);
+        qrsFuture = QtConcurrent::run([=]() {
+            findQRS(pSamplesECG, pHeartRateECG, samplesCountECG, sampleRateECG);
+        });
+    }
+    PeakDetector::findHeartRate(tasks, &mCanceled);
+    qrsFuture.waitForFinished();
+    if (isCanceled()) {
+        return false;
+    }
+
+    // ABP макс
+    const double *pIn, *pInBase;
+    double *pMax, *pMin, *pMinBase, *pMaxBase;
+    const int *pHRate;
+
+    pInBase = params.getSamples(channelABP);
+    pMinBase = minimums[channelABP].data();
+    pMaxBase = maximums[channelABP].data();
+
+    pIn = pInBase;
+    pMax = pMaxBase;
+    pHRate = heartRateABPMax.data();
+
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++, pIn++, pMax++, pHRate++) {
+        if (*pHRate != 0) {
+           *pMax = *pIn;
+        }
+    }
+    // ABP мин
+    pIn = pInBase;
+    pMin = pMinBase;
+    pMax = pMaxBase;
+    pHRate = heartRateABPMin.data();
+
+    qint64 minIndex = -1;
+    double minValue = 1e10;
+
+    // оставим минимумы только между двумя соседними максимумами)
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++, pIn++, pMin++, pMax++, pHRate++) {
+        if (*pHRate != 0 && minValue > *pIn) {
+           minValue = *pIn;
+           minIndex = sampleIndex;
+        }
+        if (*pMax != 0) {
+            if (minIndex != -1) {
+                pMinBase[minIndex] = pInBase[minIndex];
+            }
+            minIndex = -1;
+            minValue = 1e10;
+        }
+    }
+
+    heartRate[channelABP].clear();
+    emit progress(params.generation, ANALYSIS_STAGE_DETECTION, 100);
+    if (isCanceled()) {
+        return false;
+    }
+
+    // задержки пульсовой волны относительно R-зубцов по спискам пиков
+    emit progress(params.generation, ANALYSIS_STAGE_TIME_LAG, 0);
+    {
+        QElapsedTimer timer;
+        timer.start();
+        const std::vector<int> & heartRateECG = heartRate[channelECG];
+        const std::vector<int> & heartRateP = heartRate[channelP];
+        std::vector<qint64> peaksECG = TimeLagMatcher::extractPeaks(heartRateECG.data(), qint64(heartRateECG.size()));
+        std::vector<qint64> peaksP = TimeLagMatcher::extractPeaks(heartRateP.data(), qint64(heartRateP.size()));
+        params.timeLagMatcher.match(peaksECG, getSampleRate(channelECG),
+                                    peaksP, params.getSamples(channelP), getSampleRate(channelP),
+                                    timeLag[channelP].data(), params.getSamplesCount(channelP));
+        printf("Finding time lag: %zu ECG peaks, %zu pleth peaks, %lld ms\n", peaksECG.size(), peaksP.size(), timer.elapsed());
+    }
+
+    // события калибровки: на каждом отсчете АД максимум, минимум и последняя задержка пульсовой волны
+    // среди отсчетов плетизмограммы, которые соответствуют отсчетам АД до текущего включительно
+    pMin = pMinBase;
+    pMax = pMaxBase;
+    const double * pDelayS = timeLag[channelP].data();
+    qint64 plethSampleIndex = 0;
+    qint64 plethSamples = params.getSamplesCount(channelP);
+    SampleIndexMap indexMapABPToP = getIndexMap(channelABP, channelP);
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++, pMin++, pMax++) {
+        double delayS = 0;
+        qint64 plethEndIndex = qMin(plethSamples, indexMapABPToP.mapCeil(sampleIndex));
+        while (plethSampleIndex < plethEndIndex) {
+            if (*pDelayS != 0) delayS = *pDelayS;
+            pDelayS++;
+            plethSampleIndex++;
+        }
+        if (*pMin != 0 || *pMax != 0 || delayS != 0) {
+            CalibrationEvent event;
+            event.sampleIndex = sampleIndex;
+            event.minPressureMm = *pMin;
+            event.maxPressureMm = *pMax;
+            event.delayS = delayS;
+            mCalibrationEvents.push_back(event);
+        }
+    }
+
+    // результаты каналов по событиям (остальные каналы после расчета пустые)
+    int analyzedChannels[] = { channelECG, channelP, channelABP };
+    for (int channel : analyzedChannels) {
+        bool collected = false;
+        for (const ChannelResults & results : mDetectedChannels) {
+            collected = collected || results.channel == channel;
+        }
+        if (collected) {
+            continue;
+        }
+        ChannelResults results;
+        results.channel = channel;
+        collectEvents(results, params.getSamplesCount(channel), heartRate[channel], timeLag[channel],
+                      maximums[channel], minimums[channel]);
+        mDetectedChannels.push_back(std::move(results));
+    }
+    emit progress(params.generation, ANALYSIS_STAGE_TIME_LAG, 100);
+    if (isCanceled()) {
+        mDetectedChannels.clear();
+        mCalibrationEvents.clear();
+        return false;
+    }
+
+    mDetectedChannelECG = channelECG;
+    mDetectedChannelP = channelP;
+    mDetectedChannelABP = channelABP;
+    mDetectedGeneration = params.inputGeneration;
+    return true;
+}
+
+void AnalysisThread::calibrate(const AnalysisParams & params, AnalysisResult & result)
+{
+    emit progress(params.generation, ANALYSIS_STAGE_REGRESSION, 0);
+    result.generation = params.generation;
+    result.channels = mDetectedChannels;
+    ChannelResults * pABP = nullptr;
+    for (ChannelResults & results : result.channels) {
+        if (results.channel == params.channelABP) {
+            pABP = &results;
+        }
+    }
+    qint64 samplesCount = params.getSamplesCount(params.channelABP);
+    qint64 beginIndex = percentToIndex(params.beginPercent, samplesCount);
+    qint64 endIndex = percentToIndex(params.endPercent, samplesCount);
+
+    // массив давлений и задержек: пары внутри окна калибровки
+    LeastSquareMethod lsmLo;
+    LeastSquareMethod lsmHi;
+
+    DelayAndPressure item;
+    memset(&item, 0, sizeof(item));
+    auto first = std::lower_bound(mCalibrationEvents.begin(), mCalibrationEvents.end(), beginIndex,
+                                  [](const CalibrationEvent & event, qint64 index) { return event.sampleIndex < index; });
+    // задержка, учтенная до начала окна, переходит в первую пару
+    for (auto it = first; it != mCalibrationEvents.begin(); ) {
+        --it;
+        if (it->delayS != 0) {
+            item.delayS = it->delayS;
+            break;
+        }
+    }
+    for (auto it = first; it != mCalibrationEvents.end() && it->sampleIndex <= endIndex; ++it) {
+        if (it->minPressureMm != 0) item.minPressureMm = it->minPressureMm;
+        if (it->maxPressureMm != 0) item.maxPressureMm = it->maxPressureMm;
+        if (it->delayS != 0) item.delayS = it->delayS;
+
+        if (item.delayS != 0) {
+            if (item.maxPressureMm != 0 && item.minPressureMm !=0) {
+                result.delayAndPressureList.append(item);
+                lsmLo.add(item.delayS, item.minPressureMm);
+                lsmHi.add(item.delayS, item.maxPressureMm);
+                memset(&item, 0, sizeof(item));
+            }
+        }
+    }
+
+    lsmLo.calc();
+    lsmHi.calc();
+
+    result.aHi = lsmHi.getA();
+    result.bHi = lsmHi.getB();
+
+    result.aLo = lsmLo.getA();
+    result.bLo = lsmLo.getB();
+
+    result.n = lsmLo.getN();
+
+    // полный вывод пар и коэффициентов только по кнопке расчета (не при перемещении окна калибровки)
+    if (!params.calibrationOnly) {
+        printf("Delay Low High%%\n");
+        for (const DelayAndPressure & pair : result.delayAndPressureList) {
+            printf("%.4lf %.2lf %.2lf\n", pair.delayS, pair.minPressureMm, pair.maxPressureMm);
+        }
+        printf("Lo = %.2lf * T + %.2lf\n", result.aLo, result.bLo);
+        printf("Hi = %.2lf * T + %.2lf\n", result.aHi, result.bHi);
+    }
+    emit progress(params.generation, ANALYSIS_STAGE_REGRESSION, 100);
+
+    // оценка давления по задержке только для точек за пределами окна калибровки;
+    // между событиями состояние не меняется, поэтому событие внутри окна
+    // учитывается на первом отсчете после окна, если до него нет следующего события
+    emit progress(params.generation, ANALYSIS_STAGE_ESTIMATION, 0);
+    auto getEventIndex = [pABP](qint64 sampleIndex) {
+        return size_t(std::lower_bound(pABP->events.begin(), pABP->events.end(), sampleIndex) - pABP->events.begin());
+    };
+    double delay = 0;
+    qint64 minIndex = 0;
+    qint64 maxIndex = 0;
+    size_t eventsCount = mCalibrationEvents.size();
+    for (size_t i = 0; i < eventsCount; i++) {
+        const CalibrationEvent & event = mCalibrationEvents[i];
+        if (event.minPressureMm != 0) minIndex = event.sampleIndex;
+        if (event.maxPressureMm != 0) maxIndex = event.sampleIndex;
+        if (event.delayS != 0) delay = event.delayS;
+
+        if (delay == 0 || minIndex == 0 || maxIndex == 0) {
+            continue;
+        }
+        qint64 sampleIndex = event.sampleIndex;
+        if (sampleIndex >= beginIndex && sampleIndex <= endIndex) {
+            sampleIndex = endIndex + 1;
+        }
+        qint64 nextIndex = i + 1 < eventsCount ? mCalibrationEvents[i + 1].sampleIndex : samplesCount;
+        if (sampleIndex < nextIndex) {
+            // минимум и максимум АД - события канала АД
+            pABP->minimumsCalculated[getEventIndex(minIndex)] = delay * result.aLo + result.bLo;
+            pABP->maximumsCalculated[getEventIndex(maxIndex)] = delay * result.aHi + result.bHi;
+
+            delay = 0;
+            maxIndex = 0;
+            minIndex = 0;
+        }
+    }
+
+    // подписи с оценками и статистика точности
+    for (ChannelResults & results : result.channels) {
+        buildLabels(results, params.getSamplesCount(results.channel), params, result);
+        results.pressureStats.build(results.events, results.minimums, results.minimumsCalculated,
+                                    results.maximums, results.maximumsCalculated);
+    }
+    emit progress(params.generation, ANALYSIS_STAGE_ESTIMATION, 100);
+}
+
+double AnalysisThread::getSampleRate(int channel) const
+{
+    return WaveformRenderer::getSampleRate(mpEDFHeader, channel);
+}
+
+SampleIndexMap AnalysisThread::getIndexMap(int fromChannel, int toChannel) const
+{
+    return SampleIndexMap(mpEDFHeader->signalparam[fromChannel].smp_in_datarecord,
+                          mpEDFHeader->signalparam[toChannel].smp_in_datarecord);
+}
+
+PeakDetector::Task AnalysisThread::getPeakDetectorTask(const AnalysisParams & params, int channel, int * pHeartRate, int inversion) const
+{
+    PeakDetector::Task task;
+    task.pInSamples = params.getSamples(channel);
+    task.pHeartRate = pHeartRate;
+    task.samplesCount = params.getSamplesCount(channel);
+    task.sampleRate = getSampleRate(channel);
+    task.inversion = inversion;
+    return task;
+}
+
+void AnalysisThread::findQRS(const double * pInSamples, int * pHeartRate, qint64 samplesCount, double sampleRate) const
+{
+    printf("Finding QRS: start\n");
+    QElapsedTimer timer;
+    timer.start();
+    memset(pHeartRate, 0, sizeof(int) * samplesCount);
+    QRSDetector detector(sampleRate);
+    std::vector<qint64> peaks;
+    for (qint64 blockStart = 0; blockStart < samplesCount; blockStart += QRS_BLOCK_SAMPLES) {
+        if (isCanceled()) {
+            printf("Finding QRS: canceled, %lld ms\n", timer.elapsed());
+            return;
+        }
+        detector.process(pInSamples + blockStart, qMin(qint64(QRS_BLOCK_SAMPLES), samplesCount - blockStart), peaks);
+    }
+    detector.finish(peaks);
+    // ненулевое значение ЧСС для R-зубца, начиная со второго комплекса
+    for (size_t i = 1; i < peaks.size(); i++) {
+        pHeartRate[peaks[i]] = int(sampleRate * 60.0 / double(peaks[i] - peaks[i - 1]));
+    }
+    printf("Finding QRS: end, %zu complexes, %lld ms\n", peaks.size(), timer.elapsed());
+}
+
+void AnalysisThread::collectEvents(ChannelResults & channel, qint64 samplesCount, const std::vector<int> & heartRate,
+                                   const std::vector<double> & timeLag, const std::vector<double> & maximums,
+                                   const std::vector<double> & minimums)
+{
+    channel.events.clear();
+    channel.eventRateCounts.assign(1, 0);
+    channel.eventRateSums.assign(1, 0);
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++) {
+        size_t i = size_t(sampleIndex);
+        int rate = heartRate.empty() ? 0 : heartRate[i];
+        double maximum = maximums.empty() ? 0 : maximums[i];
+        double minimum = minimums.empty() ? 0 : minimums[i];
+        if (rate > 0 || maximum != 0 || minimum != 0) {
+            channel.events.push_back(sampleIndex);
+            channel.heartRate.push_back(rate);
+            channel.timeLag.push_back(timeLag.empty() ? 0 : timeLag[i]);
+            channel.maximums.push_back(maximum);
+            channel.minimums.push_back(minimum);
+            channel.maximumsCalculated.push_back(0);
+            channel.minimumsCalculated.push_back(0);
+            channel.eventRateCounts.push_back(channel.eventRateCounts.back() + (rate > 0 ? 1 : 0));
+            channel.eventRateSums.push_back(channel.eventRateSums.back() + (rate > 0 ? double(rate) : 0.0));
+        }
+    }
+}
+
+void AnalysisThread::buildLabels(ChannelResults & channel, qint64 samplesCount, const AnalysisParams & params, const AnalysisResult & result)
+{
+    channel.labels.clear();
+    qint64 calcBeginIndex = percentToIndex(params.beginPercent, samplesCount);
+    qint64 calcEndIndex = percentToIndex(params.endPercent, samplesCount);
+    // последняя подпись в каждой строке (строка задается смещением по вертикали)
+    QHash<qint32, qint64> lastInRow;
+
+    auto addLabel = [&](qint64 sampleIndex, qint32 offsetY, const QString & text) {
+        EventLabel label;
+        label.sampleIndex = sampleIndex;
+        label.offsetY = offsetY;
+        label.nextInRow = -1;
+        label.text = text;
+        qint64 labelIndex = qint64(channel.labels.size());
+        auto rowIt = lastInRow.find(offsetY);
+        if (rowIt != lastInRow.end()) {
+            channel.labels[rowIt.value()].nextInRow = labelIndex;
+        }
+        lastInRow[offsetY] = labelIndex;
+        channel.labels.push_back(label);
+    };
+
+    for (size_t eventIndex = 0; eventIndex < channel.events.size(); eventIndex++) {
+        qint64 sampleIndex = channel.events[eventIndex];
+        int peak = channel.heartRate[eventIndex];
+        double lag = channel.timeLag[eventIndex];
+        double max = channel.maximums[eventIndex];
+        double min = channel.minimums[eventIndex];
+        double maxCalc = channel.maximumsCalculated[eventIndex];
+        double minCalc = channel.minimumsCalculated[eventIndex];
+
+        if (peak > 0) {
+            QString text = QString::number(peak);
+            if (lag > 0)
+            if (sampleIndex < calcBeginIndex || sampleIndex > calcEndIndex) {
+                text = text + "/" + QString::number(int(lag*1000.0)) + "ms";
+                addLabel(sampleIndex, 20, QString::asprintf("Hi = %.2lf", result.aHi * lag + result.bHi));
+                addLabel(sampleIndex, 30, QString::asprintf("Lo = %.2lf", result.aLo * lag + result.bLo));
+            }
+            addLabel(sampleIndex, 0, text);
+        }
+        if (max != 0) {
+            addLabel(sampleIndex, -15, "h=" + QString::number(max));
+            if (maxCalc != 0) {
+                addLabel(sampleIndex, -5, QString::asprintf("e=%.1lf%%", 100.0 * fabs(max - maxCalc) / max));
+            }
+        }
+        if (min != 0) {
+            addLabel(sampleIndex, 10, "l=" + QString::number(min));
+            if (minCalc != 0) {
+                addLabel(sampleIndex, 20, QString::asprintf("e=%.1lf%%", 100.0 * fabs(min - minCalc) / min));
+            }
+        }
+    }
+}
@@ -0,0 +1,216 @@
+#ifndef ANALYSISTHREAD_H
+#define ANALYSISTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QList>
+#include <QVector>
+#include <vector>
+#include "EDFlib/edflib.h"
+#include "channelparams.h"
+#include "sampleindexmap.h"
+#include "peakdetector.h"
+#include "timelagmatcher.h"
+
+// детектор пиков канала кардиограммы: порог по нормализованной амплитуде или QRS по Пану-Томпкинсу
+#define ECG_DETECTOR_THRESHOLD 0
+#define ECG_DETECTOR_QRS 1
+
+// этапы расчета (для сообщений о ходе расчета)
+#define ANALYSIS_STAGE_DETECTION 0
+#define ANALYSIS_STAGE_TIME_LAG 1
+#define ANALYSIS_STAGE_REGRESSION 2
+#define ANALYSIS_STAGE_ESTIMATION 3
+#define ANALYSIS_STAGE_COUNT 4
+
+// массив давлений и задержек для каждого максимума ЭКГ
+struct DelayAndPressure {
+    // задержка в секундах
+    double delayS;
+    // нижнее давление, ммрс
+    double minPressureMm;
+    // верхнее давление, ммрс
+    double maxPressureMm;
+};
+
+// событие калибровки на отсчете канала АД: давление в максимуме и минимуме и задержка
+// пульсовой волны, учтенная на этом отсчете (0 - значения нет)
+struct CalibrationEvent {
+    qint64 sampleIndex;
+    double minPressureMm;
+    double maxPressureMm;
+    double delayS;
+};
+
+// параметры расчета
+// неизменяемый снимок, передается в поток расчета вместе с запросом
+struct AnalysisParams {
+    // номер запроса
+    quint64 generation;
+    // версия входных данных поиска пиков и задержек (отсчеты каналов, детектор, параметры сопоставления)
+    quint64 inputGeneration;
+    // индексы каналов кардиограммы, плетизмограммы и АД
+    int channelECG;
+    int channelP;
+    int channelABP;
+    // детектор пиков канала кардиограммы
+    int ecgDetector;
+    // сопоставление R-зубцов и пульсовых волн
+    TimeLagMatcher timeLagMatcher;
+    // окно калибровки, % длительности записи
+    int beginPercent;
+    int endPercent;
+    // только пересчет калибровки (запрос пропускается, если пики и задержки для каналов не найдены)
+    bool calibrationOnly;
+    // буферы отсчетов каналов на момент запроса (по индексу канала)
+    std::vector<SampleBuffer> samples;
+
+    AnalysisParams() {
+        generation = 0;
+        inputGeneration = 0;
+        channelECG = 1;
+        channelP = 0;
+        channelABP = 2;
+        ecgDetector = ECG_DETECTOR_THRESHOLD;
+        beginPercent = 0;
+        endPercent = 50;
+        calibrationOnly = false;
+    }
+
+    qint64 getSamplesCount(int channel) const {
+        return qint64(samples[size_t(channel)]->size());
+    }
+    const double * getSamples(int channel) const {
+        return samples[size_t(channel)]->data();
+    }
+};
+
+// результаты расчета: заменяют результаты всех каналов сразу (каналы, которых нет в channels, очищаются)
+struct AnalysisResult {
+    // номер запроса
+    quint64 generation;
+    // результаты каналов кардиограммы, плетизмограммы и АД
+    std::vector<ChannelResults> channels;
+    // массив давлений и задержек в окне калибровки
+    QList<DelayAndPressure> delayAndPressureList;
+    // коэффициенты калибровки
+    double aHi;
+    double aLo;
+    double bHi;
+    double bLo;
+    int n;
+
+    AnalysisResult() {
+        generation = 0;
+        aHi = 0;
+        aLo = 0;
+        bHi = 0;
+        bLo = 0;
+        n = 0;
+    }
+};
+
+// поток расчета: поиск пиков, задержек, калибровка и оценка давления
+// если поток занят, незапущенный запрос заменяется более новым; идущий расчет прерывается, если
+// новому запросу нужны другие пики; найденные пики и задержки кэшируются, и запрос с тем же
+// входом пересчитывает только калибровку;
+// отсчеты каналов берутся из неизменяемых буферов запроса, данные каналов интерфейса поток не читает;
+// результат забирается потоком интерфейса (takeResult), до этого следующий запрос не начинается
+class AnalysisThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AnalysisThread(QObject * parent = nullptr);
+    ~AnalysisThread();
+
+    // заголовок файла (вызывается после cancel)
+    void setEDFHeader(const edf_hdr_struct * pEDFHeader);
+    // запрос расчета
+    void requestAnalysis(const AnalysisParams & params);
+    // отмена запроса и идущего расчета с ожиданием остановки; непринятый результат отбрасывается
+    void cancel();
+    // готовый результат (false, если его нет или он отменен)
+    bool takeResult(AnalysisResult & result);
+    // результат записан в каналы, следующий запрос может начаться
+    void releaseResult();
+    // остановка потока
+    void stop();
+
+signals:
+    // ход расчета запроса generation: этап и процент его выполнения
+    void progress(quint64 generation, int stage, int percent);
+    // готов результат запроса generation
+    void analysisReady(quint64 generation);
+
+protected:
+    void run() override;
+
+private:
+    //
+    QMutex mMutex;
+    // новый запрос, принятие результата, отмена и остановка
+    QWaitCondition mCondition;
+    // поток свободен
+    QWaitCondition mIdleCondition;
+    // последний еще не начатый запрос
+    AnalysisParams mRequest;
+    bool mHasRequest;
+    // выполняемый запрос
+    AnalysisParams mRunning;
+    bool mBusy;
+    // готовый результат
+    AnalysisResult mResult;
+    bool mHasResult;
+    // результат забран и записывается в каналы
+    bool mPublishing;
+    //
+    bool mStopping;
+    // отмена выполняемого запроса (проверяется между этапами и частями отсчетов)
+    QAtomicInt mCanceled;
+    bool isCanceled() const;
+
+    // заголовок файла (используется только потоком расчета)
+    const edf_hdr_struct * mpEDFHeader;
+
+    // каналы и версия входных данных найденных пиков и задержек (0 - пики не искались)
+    int mDetectedChannelECG;
+    int mDetectedChannelP;
+    int mDetectedChannelABP;
+    quint64 mDetectedGeneration;
+    // найденные пики, максимумы, минимумы и задержки каналов (без оценок, подписей и статистики)
+    std::vector<ChannelResults> mDetectedChannels;
+    // события калибровки по возрастанию отсчета АД
+    std::vector<CalibrationEvent> mCalibrationEvents;
+    // совпадают ли пики и задержки, нужные запросам
+    static bool isSameDetection(const AnalysisParams & params, const AnalysisParams & other);
+    // актуальны ли найденные пики и задержки для запроса
+    bool isDetectionValid(const AnalysisParams & params) const;
+
+    // расчет по запросу (false при отмене или пропуске запроса)
+    bool analyze(const AnalysisParams & params, AnalysisResult & result);
+    // поиск пиков, задержек и событий калибровки (false при отмене)
+    bool detect(const AnalysisParams & params);
+    // регрессия по окну калибровки и оценка давления вне окна (только по событиям калибровки)
+    void calibrate(const AnalysisParams & params, AnalysisResult & result);
+
+    //
+    double getSampleRate(int channel) const;
+    // отображение индексов отсчетов канала fromChannel в индексы канала toChannel
+    SampleIndexMap getIndexMap(int fromChannel, int toChannel) const;
+    // задание на поиск пиков по нормализованной амплитуде в канале channel
+    // pHeartRate выходной массив пиков, ненулевое значение это измеренная ЧСС
+    // inversion инвертирование входных данных (см. PeakDetector::Task)
+    PeakDetector::Task getPeakDetectorTask(const AnalysisParams & params, int channel, int * pHeartRate, int inversion) const;
+    // поиск комплексов QRS потоковым детектором (блоками по QRS_BLOCK_SAMPLES), результат в том же виде, что у PeakDetector
+    void findQRS(const double * pInSamples, int * pHeartRate, qint64 samplesCount, double sampleRate) const;
+    // сбор событий (пики, максимумы, минимумы) и префиксных сумм ЧСС по массивам канала (пустой массив - нули)
+    static void collectEvents(ChannelResults & channel, qint64 samplesCount, const std::vector<int> & heartRate,
+                              const std::vector<double> & timeLag, const std::vector<double> & maximums,
+                              const std::vector<double> & minimums);
+    // подготовка подписей событий по окну калибровки и коэффициентам
+    static void buildLabels(ChannelResults & channel, qint64 samplesCount, const AnalysisParams & params, const AnalysisResult & result);
+};
+
+#endif // ANALYSISTHREAD_H
@@ -0,0 +1,39 @@
+#include "channelparams.h"
+#include <utility>
+
+void ChannelParams::setSamples(quint32 channelIndex, std::vector<double> channelSamples)
+{
+    index = channelIndex;
+    samples = std::make_shared<const std::vector<double>>(std::move(channelSamples));
+    qint64 samplesCountAll = samplesCount();
+    if (samplesCountAll > 0) {
+        double minSample, maxSample;
+        MinMaxPyramid::findMinMax(getSamples(), samplesCountAll, minSample, maxSample);
+        minValue = minSample;
+        maxValue = maxSample;
+    }
+    events.clear();
+    eventRateCounts.assign(1, 0);
+    eventRateSums.assign(1, 0);
+    labels.clear();
+    pressureStats.clear();
+    pyramid.build(getSamples(), samplesCountAll);
+}
+
+void ChannelParams::clearResults()
+{
+    events.clear();
+    eventRateCounts.assign(1, 0);
+    eventRateSums.assign(1, 0);
+    labels.clear();
+    pressureStats.clear();
+}
+
+void ChannelParams::applyResults(ChannelResults & results)
+{
+    events.swap(results.events);
+    eventRateCounts.swap(results.eventRateCounts);
+    eventRateSums.swap(results.eventRateSums);
+    labels.swap(results.labels);
+    std::swap(pressureStats, results.pressureStats);
+}
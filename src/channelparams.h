@@ -0,0 +1,97 @@
+#ifndef CHANNELPARAMS_H
+#define CHANNELPARAMS_H
+
+#include <QString>
+#include <memory>
+#include <vector>
+#include "minmaxpyramid.h"
+#include "pressurestats.h"
+
+// неизменяемый буфер отсчетов канала: заменяется целиком при установке отсчетов,
+// поэтому поток расчета держит ссылку на него без блокировки данных каналов
+typedef std::shared_ptr<const std::vector<double>> SampleBuffer;
+
+// подпись события (ЧСС, давление, ошибка оценки), подготавливается один раз после расчета
+struct EventLabel {
+    // отсчет события
+    qint64 sampleIndex;
+    // смещение базовой линии подписи относительно маркера по вертикали
+    qint32 offsetY;
+    // индекс следующей подписи в той же строке (-1 если нет)
+    qint64 nextInRow;
+    //
+    QString text;
+};
+
+// результаты расчета канала в отсчетах событий (пик, максимум или минимум), готовятся в потоке расчета
+struct ChannelResults {
+    // индекс канала
+    qint32 channel;
+    // отсчеты событий (по возрастанию) и значения результатов в них
+    std::vector<qint64> events;
+    std::vector<int> heartRate;
+    std::vector<double> timeLag;
+    std::vector<double> maximums;
+    std::vector<double> minimums;
+    std::vector<double> maximumsCalculated;
+    std::vector<double> minimumsCalculated;
+    // префиксные суммы ЧСС по событиям (см. ChannelParams)
+    std::vector<qint64> eventRateCounts;
+    std::vector<double> eventRateSums;
+    //
+    std::vector<EventLabel> labels;
+    //
+    PressureStats pressureStats;
+
+    ChannelResults() {
+        channel = 0;
+    }
+};
+
+struct ChannelParams {
+    // индекс канала
+    quint32 index;
+    // отсчеты
+    SampleBuffer samples;
+    // отсчеты, на которых есть пик, максимум или минимум (по возрастанию)
+    std::vector<qint64> events;
+    // префиксные суммы по событиям для сводок при плотном расположении маркеров (размер events + 1):
+    // количество событий с измеренной ЧСС и сумма ЧСС по событиям [0, i)
+    std::vector<qint64> eventRateCounts;
+    std::vector<double> eventRateSums;
+    // пирамида минимумов/максимумов для отрисовки при сильном прореживании
+    MinMaxPyramid pyramid;
+    // подписи событий (по возрастанию отсчета)
+    std::vector<EventLabel> labels;
+    // статистика точности оценки давления по событиям
+    PressureStats pressureStats;
+
+    // минимальное значение
+    qreal minValue;
+    // максимальное значение
+    qreal maxValue;
+
+    ChannelParams() {
+        index = 0;
+        samples = std::make_shared<const std::vector<double>>();
+        minValue = 0;
+        maxValue = 0;
+    }
+
+    // количество отсчетов (64 бита, многосуточные записи превышают 2^31 отсчетов)
+    qint64 samplesCount() const {
+        return qint64(samples->size());
+    }
+    //
+    const double * getSamples() const {
+        return samples->data();
+    }
+    // установка отсчетов канала: диапазон значений, обнуленные результаты расчета, пирамида
+    void setSamples(quint32 channelIndex, std::vector<double> channelSamples);
+    // обнуление результатов расчета
+    void clearResults();
+    // замена результатов расчета; списки событий, подписи и статистика забираются из results
+    void applyResults(ChannelResults & results);
+};
+
+#endif // CHANNELPARAMS_H
@@ -0,0 +1,46 @@
+#include "edfreader.h"
+#include <stdio.h>
+#include <new>
+
+// размер блока чтения отсчетов из файла
+#define READ_BLOCK_SAMPLES (1 << 20)
+
+bool EDFReader::readPhysicalSamples(int handle, int channel, qint64 samplesCount, std::vector<double> & samples)
+{
+    try {
+        samples.resize(size_t(samplesCount));
+    } catch (const std::bad_alloc &) {
+        printf("\nmalloc error\n");
+        return false;
+    }
+    qint64 count = readPhysicalSamples(handle, channel, 0, samplesCount, samples.data());
+    if (count < 0) {
+        return false;
+    }
+
+    printf("\nSamples = %lld\n", count);
+
+    samples.resize(size_t(count));
+    return true;
+}
+
+qint64 EDFReader::readPhysicalSamples(int handle, int channel, qint64 firstSample, qint64 samplesCount, double * pSamples)
+{
+    // установка позиции чтения
+    edfseek(handle, channel, firstSample, EDFSEEK_SET);
+    // чтение из файла блоками (edfread_physical_samples принимает количество отсчетов типа int)
+    qint64 count = 0;
+    while (count < samplesCount) {
+        int blockSize = int(qMin(samplesCount - count, qint64(READ_BLOCK_SAMPLES)));
+        int blockCount = edfread_physical_samples(handle, channel, blockSize, pSamples + count);
+        if (blockCount == (-1)) {
+            printf("\nerror: edf_read_physical_samples()\n");
+            return -1;
+        }
+        count += blockCount;
+        if (blockCount < blockSize) {
+            break;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,20 @@
+#ifndef EDFREADER_H
+#define EDFREADER_H
+
+#include <QtGlobal>
+#include <vector>
+#include "EDFlib/edflib.h"
+
+// чтение отсчетов каналов открытого файла EDF
+class EDFReader
+{
+public:
+    // чтение всех отсчетов канала channel (физические величины)
+    // при ошибке выделения памяти или чтения возвращает false
+    static bool readPhysicalSamples(int handle, int channel, qint64 samplesCount, std::vector<double> & samples);
+    // чтение samplesCount отсчетов канала channel начиная с firstSample в pSamples
+    // возвращает количество прочитанных отсчетов (меньше samplesCount в конце канала), -1 при ошибке чтения
+    static qint64 readPhysicalSamples(int handle, int channel, qint64 firstSample, qint64 samplesCount, double * pSamples);
+};
+
+#endif // EDFREADER_H
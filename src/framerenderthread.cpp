@@ -0,0 +1,75 @@
+#include "framerenderthread.h"
+
+FrameRenderThread::FrameRenderThread(QReadWriteLock * pDataLock, QObject * parent) : QThread(parent)
+{
+    mpDataLock = pDataLock;
+    mHasRequest = false;
+    mStopping = false;
+}
+
+FrameRenderThread::~FrameRenderThread()
+{
+    stop();
+}
+
+void FrameRenderThread::setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels)
+{
+    // поток отрисовки в это время ждет блокировку чтения данных, рендерер не используется
+    mRenderer.setData(pEDFHeader, pChannels);
+}
+
+void FrameRenderThread::requestFrame(const ViewParams & view)
+{
+    QMutexLocker locker(&mMutex);
+    mRequest = view;
+    mHasRequest = true;
+    mCondition.wakeOne();
+}
+
+void FrameRenderThread::stop()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mStopping = true;
+        mCondition.wakeOne();
+    }
+    wait();
+}
+
+void FrameRenderThread::run()
+{
+    for (;;) {
+        ViewParams view;
+        {
+            QMutexLocker locker(&mMutex);
+            while (!mHasRequest && !mStopping) {
+                mCondition.wait(&mMutex);
+            }
+            if (mStopping) {
+                return;
+            }
+            // берется только последний запрос, промежуточные отбрасываются
+            view = mRequest;
+            mHasRequest = false;
+        }
+
+        QImage frame;
+        bool complete;
+        {
+            QReadLocker locker(mpDataLock);
+            frame = mRenderer.renderFrame(view);
+            complete = mRenderer.isFrameComplete();
+        }
+        emit frameReady(frame, view.generation);
+
+        // кадр с грубыми плитками уточняется, пока не пришел новый запрос
+        // (уточненный кадр выводится с тем же номером запроса)
+        if (!complete) {
+            QMutexLocker locker(&mMutex);
+            if (!mHasRequest) {
+                mRequest = view;
+                mHasRequest = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef FRAMERENDERTHREAD_H
+#define FRAMERENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QReadWriteLock>
+#include <QImage>
+#include "waveformrenderer.h"
+
+// поток отрисовки кадров с сигналами
+// принимает снимки параметров вида; если поток занят, незапущенный запрос заменяется более новым;
+// неполный кадр (бюджет времени исчерпан) уточняется повторной отрисовкой, пока нет новых запросов;
+// данные каналов читаются под блокировкой pDataLock (запись выполняет поток интерфейса)
+class FrameRenderThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit FrameRenderThread(QReadWriteLock * pDataLock, QObject * parent = nullptr);
+    ~FrameRenderThread();
+
+    // заголовок файла и данные каналов (вызывается под блокировкой записи pDataLock)
+    void setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels);
+    // запрос кадра
+    void requestFrame(const ViewParams & view);
+    // остановка потока
+    void stop();
+
+signals:
+    // готовый кадр для запроса generation
+    void frameReady(QImage frame, quint64 generation);
+
+protected:
+    void run() override;
+
+private:
+    //
+    QReadWriteLock * mpDataLock;
+    //
+    QMutex mMutex;
+    //
+    QWaitCondition mCondition;
+    // последний еще не начатый запрос
+    ViewParams mRequest;
+    bool mHasRequest;
+    //
+    bool mStopping;
+    // используется только потоком отрисовки (и setData под блокировкой записи)
+    WaveformRenderer mRenderer;
+};
+
+#endif // FRAMERENDERTHREAD_H
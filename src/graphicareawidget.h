@@ -2,74 +2,72 @@
 #define GRAPHICAREAWIDGET_H
 
 #include <QWidget>
+#include <QImage>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QReadWriteLock>
+#include <vector>
 #include "EDFlib/edflib.h"
+#include "sampleindexmap.h"
+#include "channelparams.h"
+#include "timeaxismapper.h"
+#include "waveformrenderer.h"
+#include "analysisthread.h"
 
-#define MIN_HEART_RATE 30.0
-#define MAX_HEART_RATE 200.0
-
-struct ChannelParams {
-    // индекс канала
-    quint32 index;
-    // отсчеты (double)
-    QByteArray samples;
-    // ЧСС (int)
-    QByteArray heartRate;
-    // Отставание по времени (только в канале плетизмограммы), с (double)
-    QByteArray timeLag;
-    //
-    QByteArray maximums;
-    //
-    QByteArray minimums;
-    //
-    QByteArray maximumsCalculated;
-    //
-    QByteArray minimumsCalculated;
-
-    // масштабирующий коэффициент
-    qreal scalingFactor;
-    // минимальное значение
-    qreal minValue;
-    // максимальное значение
-    qreal maxValue;
-
-    ChannelParams() {
-        index = 0;
-        scalingFactor = 0.0;
-        minValue = 0;
-        maxValue = 0;
-    }
-};
+class FrameRenderThread;
 
-// массив давлений и задержек для каждого максимума ЭКГ
-struct DelayAndPressure {
-    // задержка в секундах
-    double delayS;
-    // нижнее давление, ммрс
-    double minPressureMm;
-    // верхнее давление, ммрс
-    double maxPressureMm;
-};
+class QPainter;
+
+// бюджет времени на подготовку плиток кадра по умолчанию, мс
+#define DEFAULT_FRAME_BUDGET_MS 30
+// минимальная высота полосы канала, пикс (при большем числе каналов включается прокрутка по вертикали)
+#define MIN_CHANNEL_HEIGHT 60
 
 class GraphicAreaWidget : public QWidget
 {
     Q_OBJECT
 public:
     explicit GraphicAreaWidget(QWidget *parent = nullptr);
+    ~GraphicAreaWidget();
 
     // передача заголовка файла с параметрами записей
     void setEDFHeader(edf_hdr_struct * pEDFHeader);
     // передача массива отсчетов для каждого из каналов
-    void setData(qint32 channelIndex, QByteArray doubleSamples);
+    void setData(qint32 channelIndex, std::vector<double> samples);
     //
     void setScalingFactor(qreal scalingFactor);
     //
     void setSweepFactor(qreal sweepFactor);
     //
     void setScroll(qreal part);
-    //
+    // первый выводимый канал (прокрутка по вертикали)
+    void setFirstChannel(int channel);
+    int getFirstChannel() const;
+    // количество видимых каналов и высота полосы канала при текущей высоте виджета
+    int getVisibleChannelCount() const;
+    int getChannelHeight() const;
+    // запуск расчета в потоке расчета (ход - calcProgress, по готовности результаты выводятся и calcFinished);
+    // если каналы и входные данные поиска пиков не менялись, пересчитывается только калибровка
     void calc(int channelECG, int channelP, int channelABP);
-    //
+    // отмена расчета (например, при изменении выбранных каналов)
+    void cancelCalc();
+    // детектор пиков канала кардиограммы (ECG_DETECTOR_THRESHOLD, ECG_DETECTOR_QRS)
+    void setECGDetector(int detector);
+    // допустимый диапазон задержки пульсовой волны, с, и ее опорная точка (FIDUCIAL_PEAK, ...)
+    void setTimeLagRange(double minLagS, double maxLagS);
+    void setFiducial(int fiducial);
+    // окно калибровки, % длительности записи (после расчета калибровка пересчитывается в потоке расчета)
     void setPressureCalcPercent(int beginPercent, int endPercent);
+    // сводка точности оценки давления за интервал [beginS, endS) от начала записи, с (endS < 0 - до конца)
+    PressureStats::Summary getPressureSummary(double beginS, double endS);
+    // заголовок файла (nullptr, если файл не открыт) и данные каналов, только для чтения в потоке интерфейса
+    const edf_hdr_struct * getEDFHeader() const;
+    const QVector<ChannelParams> & getChannels() const;
+    // бюджет времени на подготовку плиток кадра, мс (0 - кадры без грубого приближения)
+    void setFrameBudget(int milliseconds);
+    // счетчики запрошенных и фактически отрисованных кадров
+    quint64 getFramesRequested() const;
+    quint64 getFramesPainted() const;
 
 protected:
     // метод для отрисовки содержимого виджета
@@ -77,13 +75,33 @@ protected:
     // реакция на движение мыши и нажатия клавиш мыши
     void mouseMoveEvent(QMouseEvent * pEvent);
     //
+    void resizeEvent(QResizeEvent * event) override;
+    //
     void timerEvent(QTimerEvent *event) override;
+    // прокрутка каналов колесом мыши
+    void wheelEvent(QWheelEvent * event) override;
 
 signals:
-
+    // изменилась область просмотра: начало и длительность в долях записи
+    void viewChanged(qreal beginPart, qreal lengthPart);
+    // изменились отсчеты каналов
+    void samplesChanged();
+    // изменились видимые каналы: первый канал, количество и высота полосы канала
+    void channelsScrolled(int firstChannel, int visibleCount, int channelHeight);
+    // ход расчета: этап (ANALYSIS_STAGE_DETECTION, ...) и процент его выполнения
+    void calcProgress(int stage, int percent);
+    // результаты расчета выведены
+    void calcFinished();
 
 public slots:
 
+private slots:
+    // прием готового кадра из потока отрисовки (устаревшие кадры отбрасываются)
+    void onFrameReady(QImage frame, quint64 generation);
+    // ход расчета и прием результатов из потока расчета (результаты отмененных запросов отбрасываются)
+    void onAnalysisProgress(quint64 generation, int stage, int percent);
+    void onAnalysisReady(quint64 generation);
+
 private:
     //
     double mAHi;
@@ -104,33 +122,89 @@ private:
     QList<DelayAndPressure> mDelayAndPressureList;
     // заголовок файла EDF (если неопределен или ошибка открытия файла, то nullptr)
     edf_hdr_struct * mpEDFHeader;
+    // копия заголовка (исходный перезаписывается при открытии следующего файла)
+    edf_hdr_struct mEDFHeader;
+    // блокировка данных каналов: запись в потоке интерфейса, чтение в потоке отрисовки
+    QReadWriteLock mDataLock;
     // параметры и данные каналов
     QVector<ChannelParams> mChannels;
-    // масштабирующий коэффициент по умолчанию
+    // масштабирующий коэффициент (общий для всех каналов)
     qreal mScalingFactor;
     // разрешение по времени
     qreal mSweepFactor;
     // прокрутка по времени (0..1)
     qreal mScroll;
-    //
-    bool mRepaint;
-    // метод поиска пиков
-    // pInSamples входной массив отсчетов
-    // pHeartRate выходной массив пиков, ненулевое значение это измеренная ЧСС
-    // maxInterval максимальная дистанция между пиками
-    // inversion Инвертирование входных данных:
-    // -1 инвертирование
-    // 0 автоматический подбор (хорошо работает для кардиограммы с ярковыраженными пиками))
-    // 1 без инвертирования
-    void findHeartRate(double * pInSamples, int * pHeartRate, int samplesCount, double sampleRate, int inversion);
+    // первый выводимый канал
+    int mFirstChannel;
+    // наибольший первый канал, при котором нижний канал виден целиком
+    int getMaxFirstChannel() const;
+    // последние отправленные параметры видимых каналов (сигнал channelsScrolled только при изменении)
+    int mReportedFirstChannel;
+    int mReportedVisibleCount;
+    int mReportedChannelHeight;
+    // запрос перерисовки: запросы объединяются и выполняются не чаще частоты обновления экрана
+    void requestRepaint();
+    void requestRepaint(const QRegion & region);
+    // таймер ближайшего кадра
+    QBasicTimer mFrameTimer;
+    // область, ожидающая перерисовки
+    QRegion mDirtyRegion;
+    // время с последней отрисовки
+    QElapsedTimer mLastPaintTimer;
+    //
+    quint64 mFramesRequested;
+    //
+    quint64 mFramesPainted;
+    // детектор пиков канала кардиограммы
+    int mECGDetector;
     // индекс канала кардиограммы
     int mChannelECG;
     // индекс канала плетизмограммы
     int mChannelPlethism;
     //
     double getSampleRate(int channel);
-    //
-    void findTimeLag(int * pHeartRateECG, int samplesCountECG, double SampleRateECG, int * pHeartRateP, double * pTimeLag, int samplesCountP, double SampleRateP);
+    // сопоставление R-зубцов и пульсовых волн
+    TimeLagMatcher mTimeLagMatcher;
+    // версия входных данных поиска пиков и задержек (отсчеты каналов, детектор, параметры сопоставления)
+    quint64 mDetectionInputGeneration;
+    // каналы последнего расчета (-1 - расчет не запускался)
+    int mCalcChannelECG;
+    int mCalcChannelP;
+    int mCalcChannelABP;
+    // поток расчета
+    AnalysisThread * mpAnalysisThread;
+    // номер последнего запроса расчета и последнего отмененного
+    quint64 mAnalysisGeneration;
+    quint64 mCanceledAnalysisGeneration;
+    // запрос расчета по текущим параметрам
+    void requestAnalysis(bool calibrationOnly);
+
+    // количество отсчетов канала на пиксель при текущей развертке
+    double getSamplesPerPixel(int channel);
+    // левый край области просмотра в пикселях от начала записи
+    qint64 getScrollPixel();
+    // время начала записи от начала суток, мс
+    double getStartOfDayMs();
+
+    // поток отрисовки кадров
+    FrameRenderThread * mpRenderThread;
+    // последний полученный кадр с сигналами (без подсказки мыши)
+    QImage mFrame;
+    // номер последнего запрошенного и последнего выведенного кадра
+    quint64 mFrameGeneration;
+    quint64 mPresentedGeneration;
+    // версия данных и результатов расчета
+    quint64 mContentGeneration;
+    // бюджет времени на подготовку плиток кадра, мс
+    int mFrameBudgetMs;
+    // запрос кадра у потока отрисовки по снимку текущих параметров вида
+    void requestFrame();
+    // изменение данных или результатов расчета (кэш плиток в потоке отрисовки сбрасывается)
+    void invalidateContent();
+    // положение подсказки у курсора мыши
+    QRect getMouseHintRect();
+    // вывод подсказки (канал, значение, время) поверх кадра
+    void drawMouseHint(QPainter & painter);
 
 
 };
@@ -1,7 +1,21 @@
 #include "mainwindow.h"
+#include "stripexporter.h"
 #include <QApplication>
 
 int main(int argc, char *argv[]) {
+    if (StripExporter::isRequested(argc, argv)) {
+        // пакетная выгрузка полос без окна
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        QGuiApplication a(argc, argv);
+        StripExporter::Options options;
+        if (!StripExporter::parseArguments(a.arguments(), options)) {
+            return 1;
+        }
+        return StripExporter::run(options);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
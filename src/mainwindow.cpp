@@ -1,17 +1,41 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "QFileDialog"
+#include "edfreader.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow) {
     ui->setupUi(this);
     ui->statusBar->showMessage(tr("Ready"));
-    on_horizontalSlider_sliderMoved(0);
-    on_horizontalSlider_2_sliderMoved(50);
 
     mpGraphicAreaWidget = new GraphicAreaWidget(this);
     ui->horizontalLayoutPaint->addWidget(mpGraphicAreaWidget);
+    on_horizontalSlider_sliderMoved(0);
+    on_horizontalSlider_2_sliderMoved(50);
     ui->horizontalLayoutPaint->setStretch(0,0);
     ui->horizontalLayoutPaint->setStretch(1,100);
+
+    mpOverviewWidget = new OverviewWidget(this);
+    ui->verticalLayout_2->insertWidget(ui->verticalLayout_2->indexOf(ui->horizontalScrollBar), mpOverviewWidget);
+    connect(mpGraphicAreaWidget, &GraphicAreaWidget::viewChanged, mpOverviewWidget, &OverviewWidget::setViewport);
+    connect(mpGraphicAreaWidget, &GraphicAreaWidget::samplesChanged, mpOverviewWidget, &OverviewWidget::invalidate);
+    connect(mpOverviewWidget, &OverviewWidget::scrollRequested, this, &MainWindow::onOverviewScrollRequested);
+
+    // прокрутка каналов по вертикали (видна, только если каналы не помещаются по высоте)
+    mpChannelScrollBar = new QScrollBar(Qt::Vertical, this);
+    mpChannelScrollBar->setRange(0, 0);
+    mpChannelScrollBar->hide();
+    ui->horizontalLayoutPaint->addWidget(mpChannelScrollBar);
+    connect(mpChannelScrollBar, &QScrollBar::valueChanged, mpGraphicAreaWidget, &GraphicAreaWidget::setFirstChannel);
+    connect(mpGraphicAreaWidget, &GraphicAreaWidget::channelsScrolled, this, &MainWindow::onChannelsScrolled);
+
+    // расчет идет в отдельном потоке, интерфейс не блокируется
+    mpCalcProgressBar = new QProgressBar(this);
+    mpCalcProgressBar->setRange(0, 100);
+    mpCalcProgressBar->setMaximumWidth(200);
+    mpCalcProgressBar->hide();
+    ui->statusBar->addPermanentWidget(mpCalcProgressBar);
+    connect(mpGraphicAreaWidget, &GraphicAreaWidget::calcProgress, this, &MainWindow::onCalcProgress);
+    connect(mpGraphicAreaWidget, &GraphicAreaWidget::calcFinished, this, &MainWindow::onCalcFinished);
 }
 
 MainWindow::~MainWindow() {
@@ -28,7 +52,9 @@ void MainWindow::on_actionLoad_triggered() {
 
      QLayoutItem* item;
      while ( (item = ui->verticalLayoutLeft->takeAt(0)) != nullptr) {
-         item->widget()->deleteLater();
+         if (item->widget() != nullptr) {
+             item->widget()->deleteLater();
+         }
          delete item;
      }
 
@@ -56,6 +82,8 @@ void MainWindow::on_actionLoad_triggered() {
       return;
     }
 
+    // расчет по данным прежнего файла прерывается
+    cancelCalc();
     ui->statusBar->showMessage(tr("File: ") + QFileInfo(mFileName).fileName());
 
     printf("\nlibrary version: %i.%02i\n", edflib_version() / 100, edflib_version() % 100);
@@ -119,8 +147,7 @@ void MainWindow::on_actionLoad_triggered() {
         }
     }
     mpGraphicAreaWidget->setEDFHeader(&mEDFHeader);
-
-    double * pDoubleBuffer;
+    mpOverviewWidget->setData(mpGraphicAreaWidget->getEDFHeader(), &mpGraphicAreaWidget->getChannels());
 
     for (int channel = 0; channel < mEDFHeader.edfsignals; channel++) {
         QString text = mEDFHeader.signalparam[channel].label;
@@ -139,35 +166,21 @@ void MainWindow::on_actionLoad_triggered() {
              ui->comboBox_abp->setCurrentIndex(channel);
         }
 
-        unsigned long long samplesCount = mEDFHeader.signalparam[channel].smp_in_file;
+        qint64 samplesCount = mEDFHeader.signalparam[channel].smp_in_file;
 
-        pDoubleBuffer = (double *)malloc(samplesCount * sizeof(double));
-        if(pDoubleBuffer == nullptr)
-        {
-            printf("\nmalloc error\n");
+        std::vector<double> samples;
+        if (!EDFReader::readPhysicalSamples(mEDFHeader.handle, channel, samplesCount, samples)) {
             edfclose_file(mEDFHeader.handle);
             return;
         }
-        // установка позиции чтения
-        edfseek(mEDFHeader.handle, channel, 0, EDFSEEK_SET);
-        // чтение из файла
-        int count = edfread_physical_samples(mEDFHeader.handle, channel, int(samplesCount), pDoubleBuffer);
-
-        printf("\nSamples = %d\n", count);
-
-        if ( count == (-1))
-        {
-          printf("\nerror: edf_read_physical_samples()\n");
-          edfclose_file(mEDFHeader.handle);
-          free(pDoubleBuffer);
-          return;
-        }
-
-        mpGraphicAreaWidget->setData(channel, QByteArray((char*) pDoubleBuffer, int(samplesCount) * sizeof(double)));
-
-        free(pDoubleBuffer);
+        mpGraphicAreaWidget->setData(channel, std::move(samples));
     }
+    // подписи каналов выравниваются по верху, как полосы каналов
+    ui->verticalLayoutLeft->addStretch();
+    onChannelsScrolled(mpGraphicAreaWidget->getFirstChannel(), mpGraphicAreaWidget->getVisibleChannelCount(),
+                       mpGraphicAreaWidget->getChannelHeight());
     edfclose_file(mEDFHeader.handle);
+    updateOverviewChannels();
 }
 
 void MainWindow::on_comboBox_currentIndexChanged(const QString &scaleText)
@@ -188,7 +201,109 @@ void MainWindow::on_horizontalScrollBar_valueChanged(int value)
 void MainWindow::on_pushButton_clicked()
 {
     mpGraphicAreaWidget->setPressureCalcPercent(percent0, percent1);
+    mpGraphicAreaWidget->setECGDetector(ui->comboBox_detector->currentIndex() == 1 ? ECG_DETECTOR_QRS : ECG_DETECTOR_THRESHOLD);
     mpGraphicAreaWidget->calc(ui->comboBox_ecg->currentIndex(), ui->comboBox_pl->currentIndex(), ui->comboBox_abp->currentIndex());
+    updateOverviewChannels();
+    mpCalcProgressBar->setValue(0);
+    mpCalcProgressBar->show();
+}
+
+void MainWindow::onCalcProgress(int stage, int percent)
+{
+    if (!mpCalcProgressBar->isVisible()) {
+        return;
+    }
+    // этапы считаются равными по длительности
+    mpCalcProgressBar->setValue((stage * 100 + percent) / ANALYSIS_STAGE_COUNT);
+    switch (stage) {
+    case ANALYSIS_STAGE_DETECTION: ui->statusBar->showMessage(tr("Detecting peaks...")); break;
+    case ANALYSIS_STAGE_TIME_LAG: ui->statusBar->showMessage(tr("Matching time lags...")); break;
+    case ANALYSIS_STAGE_REGRESSION: ui->statusBar->showMessage(tr("Calibrating...")); break;
+    case ANALYSIS_STAGE_ESTIMATION: ui->statusBar->showMessage(tr("Estimating pressure...")); break;
+    }
+}
+
+void MainWindow::onCalcFinished()
+{
+    if (mpCalcProgressBar->isVisible()) {
+        mpCalcProgressBar->hide();
+        ui->statusBar->showMessage(tr("Ready"));
+    }
+}
+
+void MainWindow::cancelCalc()
+{
+    mpGraphicAreaWidget->cancelCalc();
+    if (mpCalcProgressBar->isVisible()) {
+        mpCalcProgressBar->hide();
+        ui->statusBar->showMessage(tr("Canceled"));
+    }
+}
+
+void MainWindow::on_comboBox_ecg_currentIndexChanged(int)
+{
+    cancelCalc();
+}
+
+void MainWindow::on_comboBox_pl_currentIndexChanged(int)
+{
+    cancelCalc();
+}
+
+void MainWindow::on_comboBox_abp_currentIndexChanged(int)
+{
+    cancelCalc();
+}
+
+void MainWindow::on_comboBox_detector_currentIndexChanged(int)
+{
+    cancelCalc();
+}
+
+void MainWindow::onOverviewScrollRequested(qreal part)
+{
+    mpGraphicAreaWidget->setScroll(part);
+    // полоса прокрутки только отражает положение (0..100), без обратного вызова setScroll
+    ui->horizontalScrollBar->blockSignals(true);
+    ui->horizontalScrollBar->setValue(qRound(part * 100.0));
+    ui->horizontalScrollBar->blockSignals(false);
+}
+
+void MainWindow::onChannelsScrolled(int firstChannel, int visibleCount, int channelHeight)
+{
+    // подписи показываются только для видимых каналов, по высоте полосы канала
+    int labelIndex = 0;
+    for (int i = 0; i < ui->verticalLayoutLeft->count(); i++) {
+        QWidget * pLabel = ui->verticalLayoutLeft->itemAt(i)->widget();
+        if (pLabel == nullptr) {
+            continue;
+        }
+        pLabel->setFixedHeight(channelHeight);
+        pLabel->setVisible(labelIndex >= firstChannel && labelIndex < firstChannel + visibleCount);
+        labelIndex++;
+    }
+
+    int channelCount = mpGraphicAreaWidget->getEDFHeader() != nullptr ? mpGraphicAreaWidget->getEDFHeader()->edfsignals : 0;
+    int fullyVisibleCount = channelHeight > 0 ? qMax(1, mpGraphicAreaWidget->height() / channelHeight) : channelCount;
+    int maximum = qMax(0, channelCount - fullyVisibleCount);
+    mpChannelScrollBar->blockSignals(true);
+    mpChannelScrollBar->setRange(0, maximum);
+    mpChannelScrollBar->setPageStep(fullyVisibleCount);
+    mpChannelScrollBar->setValue(firstChannel);
+    mpChannelScrollBar->blockSignals(false);
+    mpChannelScrollBar->setVisible(maximum > 0);
+}
+
+void MainWindow::updateOverviewChannels()
+{
+    QVector<int> channels;
+    int selected[] = { ui->comboBox_ecg->currentIndex(), ui->comboBox_pl->currentIndex(), ui->comboBox_abp->currentIndex() };
+    for (int channel : selected) {
+        if (channel >= 0 && !channels.contains(channel)) {
+            channels.append(channel);
+        }
+    }
+    mpOverviewWidget->setChannels(channels);
 }
 
 void MainWindow::on_horizontalSlider_sliderMoved(int position)
@@ -198,6 +313,8 @@ void MainWindow::on_horizontalSlider_sliderMoved(int position)
     if (percent1 <= percent0) {
         percent1 = percent0+1;
     }
+    // после расчета калибровка пересчитывается сразу при перемещении ползунка
+    mpGraphicAreaWidget->setPressureCalcPercent(percent0, percent1);
 }
 
 void MainWindow::on_horizontalSlider_2_sliderMoved(int position)
@@ -207,4 +324,5 @@ void MainWindow::on_horizontalSlider_2_sliderMoved(int position)
     if (percent1 <= percent0) {
         percent0 = percent1-1;
     }
+    mpGraphicAreaWidget->setPressureCalcPercent(percent0, percent1);
 }
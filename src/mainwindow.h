@@ -2,7 +2,10 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QScrollBar>
+#include <QProgressBar>
 #include "graphicareawidget.h"
+#include "overviewwidget.h"
 #include "EDFlib/edflib.h"
 
 namespace Ui {
@@ -34,10 +37,35 @@ private slots:
 
     void on_horizontalSlider_2_sliderMoved(int position);
 
+    void onOverviewScrollRequested(qreal part);
+
+    void onChannelsScrolled(int firstChannel, int visibleCount, int channelHeight);
+
+    void onCalcProgress(int stage, int percent);
+
+    void onCalcFinished();
+
+    void on_comboBox_ecg_currentIndexChanged(int index);
+
+    void on_comboBox_pl_currentIndexChanged(int index);
+
+    void on_comboBox_abp_currentIndexChanged(int index);
+
+    void on_comboBox_detector_currentIndexChanged(int index);
+
 private:
     Ui::MainWindow *ui;
     QString mFileName;
     GraphicAreaWidget * mpGraphicAreaWidget;
+    OverviewWidget * mpOverviewWidget;
+    // прокрутка каналов по вертикали
+    QScrollBar * mpChannelScrollBar;
+    // ход расчета (виден, пока идет расчет, запущенный кнопкой)
+    QProgressBar * mpCalcProgressBar;
+    // отмена расчета при изменении входных данных
+    void cancelCalc();
+    // каналы обзора: ЭКГ, плетизмограмма, АД (без повторов)
+    void updateOverviewChannels();
 
     edf_hdr_struct mEDFHeader;
 
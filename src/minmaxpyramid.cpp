@@ -0,0 +1,289 @@
+#include "minmaxpyramid.h"
+
+// AVX2-ядро собирается атрибутом target (GCC/Clang на x86), выбор ядра во время выполнения
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MINMAX_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define MINMAX_HAVE_AVX2 0
+#endif
+
+typedef void (*FindMinMaxFunc)(const double * pSamples, qint64 count, double & minValue, double & maxValue);
+typedef void (*BuildBucketsFunc)(const double * pSamples, qint64 count, qint64 bucketSize, MinMaxPyramid::Bucket * pBuckets);
+
+// минимум и максимум отсчетов [0, count), count > 0
+static inline void findMinMaxScalar(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    minValue = maxValue = pSamples[0];
+    for (qint64 i = 1; i < count; i++) {
+        double value = pSamples[i];
+        if (minValue > value) minValue = value;
+        if (maxValue < value) maxValue = value;
+    }
+}
+
+// блоки по bucketSize отсчетов (последний может быть неполным)
+static void buildBucketsScalar(const double * pSamples, qint64 count, qint64 bucketSize, MinMaxPyramid::Bucket * pBuckets)
+{
+    for (qint64 begin = 0; begin < count; begin += bucketSize, pBuckets++) {
+        qint64 size = qMin(bucketSize, count - begin);
+        double minValue, maxValue;
+        findMinMaxScalar(pSamples + begin, size, minValue, maxValue);
+        pBuckets->minValue = float(minValue);
+        pBuckets->maxValue = float(maxValue);
+        pBuckets->firstValue = float(pSamples[begin]);
+        pBuckets->lastValue = float(pSamples[begin + size - 1]);
+    }
+}
+
+// границы отсчетов столбца column, как в WaveformRenderer::computeTileGeometry и getRange(-1, ...);
+// false, если столбец за концом отсчетов
+static inline bool getColumnSamples(qint64 count, double samplesPerPixel, qint64 firstX, qint32 columnStep, qint32 column,
+                                    qint64 & beginSample, qint64 & endSample)
+{
+    qint64 absX = firstX + qint64(column) * columnStep;
+    beginSample = qint64(double(absX) * samplesPerPixel);
+    endSample = qint64(double(absX + columnStep) * samplesPerPixel);
+    if (beginSample >= count) {
+        return false;
+    }
+    if (endSample <= beginSample) endSample = beginSample + 1;
+    if (endSample > count) endSample = count;
+    return true;
+}
+
+#if MINMAX_HAVE_AVX2
+// то же по 4 отсчета за шаг; _mm256_min_pd(value, acc) оставляет acc для NaN,
+// как и скалярное сравнение, поэтому результат совпадает со скалярным ядром
+__attribute__((target("avx2")))
+static inline void findMinMaxAvx2(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    qint64 i = 0;
+    minValue = maxValue = pSamples[0];
+    if (count >= 4) {
+        __m256d minVector = _mm256_set1_pd(pSamples[0]);
+        __m256d maxVector = minVector;
+        for (; i + 4 <= count; i += 4) {
+            __m256d value = _mm256_loadu_pd(pSamples + i);
+            minVector = _mm256_min_pd(value, minVector);
+            maxVector = _mm256_max_pd(value, maxVector);
+        }
+        double mins[4], maxs[4];
+        _mm256_storeu_pd(mins, minVector);
+        _mm256_storeu_pd(maxs, maxVector);
+        for (int k = 0; k < 4; k++) {
+            if (minValue > mins[k]) minValue = mins[k];
+            if (maxValue < maxs[k]) maxValue = maxs[k];
+        }
+    }
+    for (; i < count; i++) {
+        double value = pSamples[i];
+        if (minValue > value) minValue = value;
+        if (maxValue < value) maxValue = value;
+    }
+}
+
+__attribute__((target("avx2")))
+static void findMinMaxAvx2Entry(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    findMinMaxAvx2(pSamples, count, minValue, maxValue);
+}
+
+__attribute__((target("avx2")))
+static void buildBucketsAvx2(const double * pSamples, qint64 count, qint64 bucketSize, MinMaxPyramid::Bucket * pBuckets)
+{
+    for (qint64 begin = 0; begin < count; begin += bucketSize, pBuckets++) {
+        qint64 size = qMin(bucketSize, count - begin);
+        double minValue, maxValue;
+        findMinMaxAvx2(pSamples + begin, size, minValue, maxValue);
+        pBuckets->minValue = float(minValue);
+        pBuckets->maxValue = float(maxValue);
+        pBuckets->firstValue = float(pSamples[begin]);
+        pBuckets->lastValue = float(pSamples[begin + size - 1]);
+    }
+}
+
+static bool cpuHasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+static void findMinMaxScalarEntry(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    findMinMaxScalar(pSamples, count, minValue, maxValue);
+}
+
+// выбранные ядра
+struct MinMaxKernels {
+    FindMinMaxFunc findMinMax;
+    BuildBucketsFunc buildBuckets;
+};
+
+static MinMaxKernels selectKernels()
+{
+#if MINMAX_HAVE_AVX2
+    if (cpuHasAvx2()) {
+        return { findMinMaxAvx2Entry, buildBucketsAvx2 };
+    }
+#endif
+    return { findMinMaxScalarEntry, buildBucketsScalar };
+}
+
+static const MinMaxKernels & getKernels()
+{
+    static const MinMaxKernels kernels = selectKernels();
+    return kernels;
+}
+
+void MinMaxPyramid::findMinMax(const double * pSamples, qint64 count, double & minValue, double & maxValue)
+{
+    if (count <= 0) {
+        minValue = maxValue = 0;
+        return;
+    }
+    getKernels().findMinMax(pSamples, count, minValue, maxValue);
+}
+
+void MinMaxPyramid::buildBuckets(const double * pSamples, qint64 count, qint64 bucketSize, Bucket * pBuckets)
+{
+    getKernels().buildBuckets(pSamples, count, bucketSize, pBuckets);
+}
+
+MinMaxPyramid::Column MinMaxPyramid::getColumn(const Bucket & bucket, const YMapping & mapping)
+{
+    Column result;
+    result.yTop = mapping.toY(bucket.maxValue);
+    result.yBottom = mapping.toY(bucket.minValue);
+    result.falling = bucket.firstValue > bucket.lastValue;
+    return result;
+}
+
+qint32 MinMaxPyramid::buildColumns(const double * pSamples, qint64 count, double samplesPerPixel, qint64 firstX,
+                                   qint32 columnStep, qint32 columnCount, const YMapping & mapping, Column * pColumns)
+{
+    // столбцы строятся скалярно: по пирамиде не берутся только столбцы короче LEVEL_FACTOR * columnStep отсчетов,
+    // на них AVX2 не дает выигрыша (bench/minmax)
+    for (qint32 column = 0; column < columnCount; column++) {
+        qint64 beginSample, endSample;
+        if (!getColumnSamples(count, samplesPerPixel, firstX, columnStep, column, beginSample, endSample)) {
+            return column;
+        }
+        double minValue, maxValue;
+        findMinMaxScalar(pSamples + beginSample, endSample - beginSample, minValue, maxValue);
+        Column & result = pColumns[column];
+        result.yTop = mapping.toY(double(float(maxValue)));
+        result.yBottom = mapping.toY(double(float(minValue)));
+        result.falling = float(pSamples[beginSample]) > float(pSamples[endSample - 1]);
+    }
+    return columnCount;
+}
+
+void MinMaxPyramid::clear()
+{
+    mSamplesCount = 0;
+    mLevels.clear();
+}
+
+void MinMaxPyramid::build(const double * pSamples, qint64 samplesCount)
+{
+    clear();
+    mSamplesCount = samplesCount;
+    if (samplesCount <= LEVEL_FACTOR) {
+        return;
+    }
+
+    // уровень 0 из исходных отсчетов
+    std::vector<Bucket> level((samplesCount + LEVEL_FACTOR - 1) / LEVEL_FACTOR);
+    buildBuckets(pSamples, samplesCount, LEVEL_FACTOR, level.data());
+    mLevels.push_back(std::move(level));
+
+    // следующие уровни из предыдущих, пока в уровне больше одного блока
+    while (mLevels.back().size() > 1) {
+        const std::vector<Bucket> & prev = mLevels.back();
+        qint64 prevCount = qint64(prev.size());
+        std::vector<Bucket> next((prevCount + LEVEL_FACTOR - 1) / LEVEL_FACTOR);
+        for (qint64 bucketIndex = 0; bucketIndex < qint64(next.size()); bucketIndex++) {
+            qint64 begin = bucketIndex * LEVEL_FACTOR;
+            qint64 end = qMin(begin + LEVEL_FACTOR, prevCount);
+            Bucket & bucket = next[bucketIndex];
+            bucket = prev[begin];
+            for (qint64 i = begin + 1; i < end; i++) {
+                if (bucket.minValue > prev[i].minValue) bucket.minValue = prev[i].minValue;
+                if (bucket.maxValue < prev[i].maxValue) bucket.maxValue = prev[i].maxValue;
+            }
+            bucket.lastValue = prev[end - 1].lastValue;
+        }
+        mLevels.push_back(std::move(next));
+    }
+}
+
+int MinMaxPyramid::getLevelCount() const
+{
+    return int(mLevels.size());
+}
+
+qint64 MinMaxPyramid::getBucketSize(int level) const
+{
+    qint64 size = 1;
+    for (int i = 0; i <= level; i++) {
+        size *= LEVEL_FACTOR;
+    }
+    return size;
+}
+
+qint64 MinMaxPyramid::getBucketCount(int level) const
+{
+    if (level < 0) {
+        return mSamplesCount;
+    }
+    return qint64(mLevels[level].size());
+}
+
+const MinMaxPyramid::Bucket * MinMaxPyramid::getLevel(int level) const
+{
+    return mLevels[level].data();
+}
+
+int MinMaxPyramid::findLevel(double samplesPerPixel) const
+{
+    int level = -1;
+    while (level + 1 < getLevelCount() && double(getBucketSize(level + 1)) <= samplesPerPixel) {
+        level++;
+    }
+    return level;
+}
+
+MinMaxPyramid::Bucket MinMaxPyramid::getRange(int level, qint64 beginSample, qint64 endSample, const double * pSamples) const
+{
+    Bucket result;
+    if (level < 0) {
+        if (endSample <= beginSample) endSample = beginSample + 1;
+        if (endSample > mSamplesCount) endSample = mSamplesCount;
+        double minValue, maxValue;
+        findMinMax(pSamples + beginSample, endSample - beginSample, minValue, maxValue);
+        result.minValue = float(minValue);
+        result.maxValue = float(maxValue);
+        result.firstValue = float(pSamples[beginSample]);
+        result.lastValue = float(pSamples[endSample - 1]);
+        return result;
+    }
+
+    qint64 bucketSize = getBucketSize(level);
+    qint64 bucketCount = getBucketCount(level);
+    qint64 beginBucket = beginSample / bucketSize;
+    qint64 endBucket = endSample / bucketSize;
+    if (beginBucket >= bucketCount) beginBucket = bucketCount - 1;
+    if (endBucket <= beginBucket) endBucket = beginBucket + 1;
+    if (endBucket > bucketCount) endBucket = bucketCount;
+
+    const Bucket * pBuckets = mLevels[level].data();
+    result = pBuckets[beginBucket];
+    for (qint64 i = beginBucket + 1; i < endBucket; i++) {
+        if (result.minValue > pBuckets[i].minValue) result.minValue = pBuckets[i].minValue;
+        if (result.maxValue < pBuckets[i].maxValue) result.maxValue = pBuckets[i].maxValue;
+    }
+    result.lastValue = pBuckets[endBucket - 1].lastValue;
+    return result;
+}
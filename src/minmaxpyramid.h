@@ -0,0 +1,88 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QtGlobal>
+#include <vector>
+
+// многоуровневая пирамида минимумов/максимумов канала
+// уровень 0 объединяет по LEVEL_FACTOR исходных отсчетов, каждый следующий уровень
+// объединяет по LEVEL_FACTOR блоков предыдущего; строится один раз при загрузке канала
+// и позволяет отрисовывать канал за время, зависящее только от ширины экрана
+class MinMaxPyramid
+{
+public:
+    // коэффициент прореживания между соседними уровнями
+    static const int LEVEL_FACTOR = 8;
+
+    // сводка по блоку отсчетов (float для экономии памяти, точности хватает для отрисовки)
+    struct Bucket {
+        float minValue;
+        float maxValue;
+        // первое и последнее значение в блоке (для непрерывности ломаной)
+        float firstValue;
+        float lastValue;
+    };
+
+    // отображение значения отсчета в координату Y полосы канала
+    struct YMapping {
+        // значение в середине полосы
+        double meanValue;
+        // пикселей на единицу значения
+        double scale;
+        // середина полосы, пикс
+        qint32 startY;
+        // высота полосы, пикс (координата ограничивается [0, height - 1])
+        qint32 height;
+
+        qint32 toY(double value) const {
+            qint32 y = startY - (qint32)((value - meanValue) * scale);
+            if (y < 0) y = 0;
+            if (y > height - 1) y = height - 1;
+            return y;
+        }
+    };
+
+    // столбец ломаной
+    struct Column {
+        // координаты Y максимума и минимума
+        qint32 yTop;
+        qint32 yBottom;
+        // спад внутри столбца (первое значение больше последнего)
+        bool falling;
+    };
+
+    void clear();
+    // построение пирамиды по массиву отсчетов
+    void build(const double * pSamples, qint64 samplesCount);
+    //
+    int getLevelCount() const;
+    // количество исходных отсчетов в блоке уровня
+    qint64 getBucketSize(int level) const;
+    //
+    qint64 getBucketCount(int level) const;
+    //
+    const Bucket * getLevel(int level) const;
+    // уровень с наибольшим блоком, не превышающим samplesPerPixel (-1 - исходные отсчеты)
+    int findLevel(double samplesPerPixel) const;
+    // сводка по отсчетам [beginSample, endSample) с использованием уровня level
+    // (на уровнях пирамиды границы выравниваются по блокам)
+    Bucket getRange(int level, qint64 beginSample, qint64 endSample, const double * pSamples) const;
+    // минимум и максимум отсчетов [0, count) (AVX2 при поддержке процессором, иначе скалярно)
+    static void findMinMax(const double * pSamples, qint64 count, double & minValue, double & maxValue);
+    // сводки по блокам из bucketSize отсчетов, последний блок может быть неполным
+    static void buildBuckets(const double * pSamples, qint64 count, qint64 bucketSize, Bucket * pBuckets);
+    // столбец по сводке
+    static Column getColumn(const Bucket & bucket, const YMapping & mapping);
+    // столбцы ломаной по исходным отсчетам [0, count): столбец i охватывает отсчеты
+    // [(firstX + i * columnStep) * samplesPerPixel, (firstX + (i + 1) * columnStep) * samplesPerPixel), но не меньше одного;
+    // значения округляются до float, как в сводках пирамиды, поэтому столбцы совпадают с getColumn(getRange(-1, ...));
+    // возвращает количество столбцов до конца отсчетов (не больше columnCount)
+    static qint32 buildColumns(const double * pSamples, qint64 count, double samplesPerPixel, qint64 firstX,
+                               qint32 columnStep, qint32 columnCount, const YMapping & mapping, Column * pColumns);
+
+private:
+    qint64 mSamplesCount = 0;
+    std::vector<std::vector<Bucket>> mLevels;
+};
+
+#endif // MINMAXPYRAMID_H
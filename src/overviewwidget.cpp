@@ -0,0 +1,158 @@
+#include "overviewwidget.h"
+#include <QPainter>
+#include <QMouseEvent>
+
+// высота обзора, пикс
+#define OVERVIEW_HEIGHT 60
+// минимальная ширина рамки области просмотра, пикс
+#define VIEWPORT_MIN_WIDTH 3
+
+OverviewWidget::OverviewWidget(QWidget *parent) : QWidget(parent)
+{
+    mpEDFHeader = nullptr;
+    mpChannels = nullptr;
+    mViewportBegin = 0;
+    mViewportLength = 0;
+    mDragging = false;
+    mDragOffset = 0;
+    setFixedHeight(OVERVIEW_HEIGHT);
+    setCursor(Qt::PointingHandCursor);
+}
+
+void OverviewWidget::setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels)
+{
+    mpEDFHeader = pEDFHeader;
+    mpChannels = pChannels;
+    invalidate();
+}
+
+void OverviewWidget::setChannels(const QVector<int> & channels)
+{
+    mChannels = channels;
+    invalidate();
+}
+
+void OverviewWidget::setViewport(qreal beginPart, qreal lengthPart)
+{
+    mViewportBegin = beginPart;
+    mViewportLength = lengthPart;
+    update();
+}
+
+void OverviewWidget::invalidate()
+{
+    mImage = QImage();
+    update();
+}
+
+void OverviewWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    if (mImage.size() != size()) {
+        mImage = renderOverview();
+    }
+
+    QPainter painter(this);
+    painter.drawImage(0, 0, mImage);
+
+    if (mpEDFHeader == nullptr) {
+        return;
+    }
+    // затенение вне области просмотра и рамка
+    QRect viewportRect = getViewportRect();
+    QColor shade(128, 128, 128, 64);
+    painter.fillRect(QRect(0, 0, viewportRect.left(), height()), shade);
+    painter.fillRect(QRect(viewportRect.right() + 1, 0, width() - viewportRect.right() - 1, height()), shade);
+    painter.setPen(Qt::blue);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(viewportRect.adjusted(0, 0, -1, -1));
+}
+
+QImage OverviewWidget::renderOverview()
+{
+    QImage image(size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    if (mpEDFHeader == nullptr || mpChannels == nullptr || width() <= 0 || mChannels.isEmpty()) {
+        return image;
+    }
+
+    QPainter painter(&image);
+    painter.setPen(Qt::lightGray);
+    painter.drawLine(0, height() - 1, width(), height() - 1);
+
+    qint32 rowHeight = height() / mChannels.size();
+    for (int row = 0; row < mChannels.size(); row++) {
+        int channel = mChannels[row];
+        if (channel < 0 || channel >= mpChannels->size()) {
+            continue;
+        }
+        const ChannelParams & params = mpChannels->at(channel);
+        qint64 samplesCount = params.samplesCount();
+        if (samplesCount == 0) {
+            continue;
+        }
+        // по одной сводке на столбец с уровня пирамиды, ближайшего к количеству отсчетов на пиксель
+        double samplesPerPixel = double(samplesCount) / double(width());
+        int level = params.pyramid.findLevel(samplesPerPixel);
+        double valueRange = params.maxValue - params.minValue;
+        double scale = valueRange > 0 ? double(rowHeight - 2) / valueRange : 0;
+        qint32 rowTop = row * rowHeight + 1;
+
+        painter.setPen(Qt::darkGray);
+        for (qint32 x = 0; x < width(); x++) {
+            qint64 beginSample = qint64(double(x) * samplesPerPixel);
+            qint64 endSample = qMin(samplesCount, qint64(double(x + 1) * samplesPerPixel));
+            if (beginSample >= samplesCount) break;
+            MinMaxPyramid::Bucket bucket = params.pyramid.getRange(level, beginSample, endSample, params.getSamples());
+            qint32 yTop = rowTop + qint32((params.maxValue - bucket.maxValue) * scale);
+            qint32 yBottom = rowTop + qint32((params.maxValue - bucket.minValue) * scale);
+            painter.drawLine(x, yTop, x, yBottom);
+        }
+    }
+    return image;
+}
+
+QRect OverviewWidget::getViewportRect()
+{
+    int x = int(mViewportBegin * qreal(width()));
+    int w = qMax(VIEWPORT_MIN_WIDTH, int(mViewportLength * qreal(width())));
+    return QRect(x, 0, w, height());
+}
+
+void OverviewWidget::scrollTo(int x)
+{
+    qreal part = qreal(x) / qreal(qMax(1, width()));
+    qreal maxPart = qMax(qreal(0), 1 - mViewportLength);
+    part = qBound(qreal(0), part, maxPart);
+    emit scrollRequested(part);
+}
+
+void OverviewWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || mpEDFHeader == nullptr) {
+        return;
+    }
+    QRect viewportRect = getViewportRect();
+    if (viewportRect.contains(event->pos())) {
+        mDragOffset = event->pos().x() - viewportRect.left();
+    } else {
+        // переход: рамка центрируется на точке нажатия
+        mDragOffset = viewportRect.width() / 2;
+        scrollTo(event->pos().x() - mDragOffset);
+    }
+    mDragging = true;
+}
+
+void OverviewWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (mDragging) {
+        scrollTo(event->pos().x() - mDragOffset);
+    }
+}
+
+void OverviewWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        mDragging = false;
+    }
+}
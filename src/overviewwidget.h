@@ -0,0 +1,64 @@
+#ifndef OVERVIEWWIDGET_H
+#define OVERVIEWWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QVector>
+#include "EDFlib/edflib.h"
+#include "channelparams.h"
+
+// обзор всей записи по выбранным каналам с перетаскиваемой рамкой области просмотра
+// изображение строится по пирамидам минимумов/максимумов каналов за время O(ширина)
+// и перестраивается только при изменении данных, каналов или размера
+class OverviewWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit OverviewWidget(QWidget *parent = nullptr);
+
+    // заголовок файла и данные каналов (принадлежат GraphicAreaWidget)
+    void setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels);
+    // индексы отображаемых каналов
+    void setChannels(const QVector<int> & channels);
+
+signals:
+    // запрос прокрутки к части записи (0..1)
+    void scrollRequested(qreal part);
+
+public slots:
+    // область просмотра: начало и длительность в долях записи
+    void setViewport(qreal beginPart, qreal lengthPart);
+    // данные каналов изменились
+    void invalidate();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    //
+    const edf_hdr_struct * mpEDFHeader;
+    //
+    const QVector<ChannelParams> * mpChannels;
+    //
+    QVector<int> mChannels;
+    // изображение обзора (пустое - требуется перестроение)
+    QImage mImage;
+    // область просмотра в долях записи
+    qreal mViewportBegin;
+    qreal mViewportLength;
+    // перетаскивание рамки: смещение курсора от левого края рамки, пикс
+    bool mDragging;
+    int mDragOffset;
+
+    // построение изображения обзора
+    QImage renderOverview();
+    // рамка области просмотра
+    QRect getViewportRect();
+    // прокрутка так, чтобы левый край рамки оказался в точке x
+    void scrollTo(int x);
+};
+
+#endif // OVERVIEWWIDGET_H
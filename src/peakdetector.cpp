@@ -0,0 +1,227 @@
+#include "peakdetector.h"
+#include "rollingstatistics.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <string.h>
+#include <limits>
+
+// размер части массива для параллельного поиска пиков, отсчетов
+#define PEAK_CHUNK_SAMPLES (1024 * 1024)
+// порог пика по нормализованной амплитуде
+#define PEAK_BARRIER 0.8
+
+void PeakDetector::findHeartRate(const QVector<Task> & tasks, const QAtomicInt * pCanceled)
+{
+    findHeartRate(tasks, PEAK_CHUNK_SAMPLES, pCanceled);
+}
+
+void PeakDetector::findHeartRate(const QVector<Task> & tasks, qint64 chunkSamples, const QAtomicInt * pCanceled)
+{
+    printf("Finding peaks: start\n");
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<Pass> passes(tasks.size());
+    QVector<Chunk> chunks;
+    for (int taskIndex = 0; taskIndex < tasks.size(); taskIndex++) {
+        const Task & task = tasks[taskIndex];
+        Pass & pass = passes[taskIndex];
+        pass.windowSize = int(task.sampleRate / (MIN_HEART_RATE / 60.));
+        pass.minInterval = int(task.sampleRate / (MAX_HEART_RATE / 60.));
+        pass.normSamples.resize(size_t(task.samplesCount));
+        pass.inverted = false;
+        memset(task.pHeartRate, 0, sizeof(int) * task.samplesCount);
+        for (qint64 beginIndex = 0; beginIndex < task.samplesCount; beginIndex += chunkSamples) {
+            Chunk chunk;
+            chunk.task = taskIndex;
+            chunk.beginIndex = beginIndex;
+            chunk.endIndex = qMin(task.samplesCount, beginIndex + chunkSamples);
+            chunk.aboveMean = 0;
+            chunks.append(chunk);
+        }
+    }
+
+    // нормализация частей (окно каждого отсчета заходит в следующую часть, данные только читаются)
+    const Task * pTasks = tasks.constData();
+    Pass * pPasses = passes.data();
+    auto isCanceled = [pCanceled]() {
+        return pCanceled != nullptr && pCanceled->loadAcquire() != 0;
+    };
+    QtConcurrent::blockingMap(chunks, [pTasks, pPasses, isCanceled](Chunk & chunk) {
+        if (isCanceled()) {
+            return;
+        }
+        normalize(pTasks[chunk.task], pPasses[chunk.task], chunk);
+    });
+    if (isCanceled()) {
+        printf("Finding peaks: canceled, %lld ms\n", timer.elapsed());
+        return;
+    }
+
+    // проверка инверсии данных по всему массиву
+    QVector<qint64> aboveMean(tasks.size(), 0);
+    for (const Chunk & chunk : chunks) {
+        aboveMean[chunk.task] += chunk.aboveMean;
+    }
+    for (int taskIndex = 0; taskIndex < tasks.size(); taskIndex++) {
+        const Task & task = tasks[taskIndex];
+        passes[taskIndex].inverted = task.inversion < 0 || (task.inversion == 0 && aboveMean[taskIndex] > task.samplesCount / 2);
+    }
+
+    // поиск пиков в каждой части с начальным состоянием; записываются только отсчеты своей части
+    QtConcurrent::blockingMap(chunks, [pTasks, pPasses, isCanceled](Chunk & chunk) {
+        if (isCanceled()) {
+            return;
+        }
+        const Task & task = pTasks[chunk.task];
+        Pass & pass = pPasses[chunk.task];
+        if (pass.inverted) {
+            double * pNormData = pass.normSamples.data();
+            for (qint64 i = chunk.beginIndex; i < chunk.endIndex; i++) {
+                pNormData[i] = 1.0 - pNormData[i];
+            }
+        }
+        State state = getInitialState(task.samplesCount);
+        chunk.runs.clear();
+        for (qint64 i = chunk.beginIndex; i < chunk.endIndex; i++) {
+            step(task, pass, i, state, &chunk.runs);
+        }
+        chunk.endState = state;
+    });
+    if (isCanceled()) {
+        printf("Finding peaks: canceled, %lld ms\n", timer.elapsed());
+        return;
+    }
+
+    // объединение частей по порядку: начало части проходится заново с действительным состоянием
+    // конца предыдущей части, пока оно не совпадет с состоянием прохода части (вне пика, тот же
+    // предыдущий максимум); дальше результаты прохода части совпадают с последовательным проходом
+    State state;
+    for (int chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++) {
+        const Chunk & chunk = chunks[chunkIndex];
+        const Task & task = tasks[chunk.task];
+        const Pass & pass = passes[chunk.task];
+        if (chunk.beginIndex == 0) {
+            state = chunk.endState;
+            continue;
+        }
+        qint64 chunkPrevMaxIndex = getInitialState(task.samplesCount).prevMaxIndex;
+        size_t runIndex = 0;
+        bool converged = false;
+        for (qint64 i = chunk.beginIndex; i < chunk.endIndex; i++) {
+            // пики части, завершившиеся до отсчета i
+            while (runIndex < chunk.runs.size() && chunk.runs[runIndex].endIndex < i) {
+                chunkPrevMaxIndex = chunk.runs[runIndex].prevMaxIndex;
+                runIndex++;
+            }
+            bool chunkInPeak = runIndex < chunk.runs.size() && chunk.runs[runIndex].startIndex < i;
+            if (!state.inPeak && !chunkInPeak && state.prevMaxIndex == chunkPrevMaxIndex) {
+                converged = true;
+                break;
+            }
+            step(task, pass, i, state, nullptr);
+        }
+        if (converged) {
+            state = chunk.endState;
+        }
+    }
+
+    printf("Finding peaks: end, %lld ms\n", timer.elapsed());
+}
+
+PeakDetector::State PeakDetector::getInitialState(qint64 samplesCount)
+{
+    State state;
+    state.inPeak = false;
+    state.peakStartedIndex = 0;
+    state.maxIndex = 0;
+    state.maxValue = 0.0;
+    state.prevMaxIndex = -samplesCount;
+    return state;
+}
+
+void PeakDetector::normalize(const Task & task, Pass & pass, Chunk & chunk)
+{
+    // нормализация данных, приведение максимумов и минимумов по окну [i, i + windowSize);
+    // у конца записи используется последнее полное окно, начинающееся с lastWindowStart
+    // (последний отсчет в окна не входит); при записи короче окна окно нулевое
+    int windowSize = pass.windowSize;
+    qint64 samplesCount = task.samplesCount;
+    qint64 lastWindowStart = windowSize > 0 ? samplesCount - windowSize - 1 : -1;
+    RollingStatistics window(windowSize);
+    qint64 nextWindowSample = qMin(chunk.beginIndex, lastWindowStart);
+    double minValue = 0.;
+    double maxValue = 0.;
+    const double * pInData = task.pInSamples;
+    double * pNormData = pass.normSamples.data();
+    qint64 aboveMean = 0;
+    for (qint64 i = chunk.beginIndex; i < chunk.endIndex; i++) {
+        qint64 windowStart = qMin(i, lastWindowStart);
+        if (windowStart >= 0 && nextWindowSample < windowStart + windowSize) {
+            // окно сдвигается на один отсчет: O(1) в среднем вместо просмотра всего окна
+            while (nextWindowSample < windowStart + windowSize) {
+                window.add(pInData[nextWindowSample++]);
+            }
+            minValue = window.getMin();
+            maxValue = window.getMax();
+        }
+        if (maxValue == minValue) {
+            pNormData[i] = 0;
+        } else {
+            pNormData[i] = (pInData[i] - minValue) / (maxValue - minValue);
+        }
+        if (pNormData[i] > 0.5) aboveMean++;
+    }
+    chunk.aboveMean = aboveMean;
+}
+
+void PeakDetector::step(const Task & task, const Pass & pass, qint64 i, State & state, std::vector<Run> * pRuns)
+{
+    double value = pass.normSamples[size_t(i)];
+    int * pHeartRate = task.pHeartRate;
+    if (value > PEAK_BARRIER && i - state.prevMaxIndex > pass.minInterval) {
+        *(pHeartRate + i) = 1;
+        // пик начался?
+        if (i > 0 && !state.inPeak) {
+            state.peakStartedIndex = i;
+            state.maxIndex = 0;
+            state.maxValue = 0.0;
+        }
+        if (!state.inPeak && pRuns != nullptr) {
+            Run run;
+            run.startIndex = i;
+            run.endIndex = std::numeric_limits<qint64>::max();
+            run.prevMaxIndex = state.prevMaxIndex;
+            pRuns->push_back(run);
+        }
+        if (state.maxValue < value) {
+            state.maxIndex = i;
+            state.maxValue = value;
+        }
+        state.inPeak = true;
+    } else {
+        // отсчет мог быть отмечен при проходе части с другим начальным состоянием
+        *(pHeartRate + i) = 0;
+        // пик закончился?
+        if (i > 0 && state.inPeak) {
+            if (state.peakStartedIndex < i - 1) {
+                // уточняем положение максимума
+                for (qint64 j = state.peakStartedIndex; j < i; j++) {
+                    *(pHeartRate + j) = 0;
+                }
+                // ненулевое значение ЧСС для максимального значения пика
+                if (state.prevMaxIndex != -1) {
+                    // ЧСС
+                    *(pHeartRate + state.maxIndex) = int(task.sampleRate * 60.0 / double(state.maxIndex - state.prevMaxIndex));
+                }
+                state.prevMaxIndex = state.maxIndex;
+            }
+            if (pRuns != nullptr && !pRuns->empty()) {
+                pRuns->back().endIndex = i;
+                pRuns->back().prevMaxIndex = state.prevMaxIndex;
+            }
+        }
+        state.inPeak = false;
+    }
+}
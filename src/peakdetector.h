@@ -0,0 +1,92 @@
+#ifndef PEAKDETECTOR_H
+#define PEAKDETECTOR_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QVector>
+#include <vector>
+
+#define MIN_HEART_RATE 30.0
+#define MAX_HEART_RATE 200.0
+
+// поиск пиков по амплитуде, нормализованной в скользящем окне 60 / MIN_HEART_RATE с (порог 0.8)
+// несколько массивов и части длинных массивов обрабатываются параллельно в пуле потоков;
+// результат совпадает с последовательным проходом
+class PeakDetector
+{
+    friend class RollingBench;
+
+public:
+    // задание на поиск пиков в одном массиве
+    struct Task {
+        // входной массив отсчетов
+        const double * pInSamples;
+        // выходной массив пиков, ненулевое значение это измеренная ЧСС
+        int * pHeartRate;
+        //
+        qint64 samplesCount;
+        //
+        double sampleRate;
+        // инвертирование входных данных:
+        // -1 инвертирование
+        // 0 автоматический подбор (хорошо работает для кардиограммы с ярковыраженными пиками))
+        // 1 без инвертирования
+        int inversion;
+    };
+
+    // поиск пиков по всем заданиям; массивы длиннее chunkSamples делятся на части
+    // при ненулевом *pCanceled поиск прекращается после текущих частей (результат неполный)
+    static void findHeartRate(const QVector<Task> & tasks, qint64 chunkSamples, const QAtomicInt * pCanceled = nullptr);
+    static void findHeartRate(const QVector<Task> & tasks, const QAtomicInt * pCanceled = nullptr);
+
+private:
+    // состояние прохода по нормализованным данным перед очередным отсчетом
+    struct State {
+        // предыдущий отсчет выше порога (идет пик)
+        bool inPeak;
+        // начало текущего пика
+        qint64 peakStartedIndex;
+        // максимум текущего пика
+        qint64 maxIndex;
+        double maxValue;
+        // максимум предыдущего пика
+        qint64 prevMaxIndex;
+    };
+
+    // пик, найденный при проходе части: отсчеты [startIndex, endIndex) выше порога,
+    // prevMaxIndex - максимум предыдущего пика после его завершения
+    struct Run {
+        qint64 startIndex;
+        qint64 endIndex;
+        qint64 prevMaxIndex;
+    };
+
+    // часть массива одного задания
+    struct Chunk {
+        int task;
+        qint64 beginIndex;
+        qint64 endIndex;
+        // отсчетов выше 0.5 после нормализации
+        qint64 aboveMean;
+        // пики и состояние в конце части при проходе с начальным состоянием (без учета предыдущих частей)
+        std::vector<Run> runs;
+        State endState;
+    };
+
+    // параметры прохода задания
+    struct Pass {
+        std::vector<double> normSamples;
+        qint64 minInterval;
+        int windowSize;
+        bool inverted;
+    };
+
+    // начальное состояние прохода
+    static State getInitialState(qint64 samplesCount);
+    // нормализация отсчетов части
+    static void normalize(const Task & task, Pass & pass, Chunk & chunk);
+    // обработка одного отсчета (pRuns - запись найденных пиков, если не nullptr)
+    static void step(const Task & task, const Pass & pass, qint64 index, State & state, std::vector<Run> * pRuns);
+};
+
+#endif // PEAKDETECTOR_H
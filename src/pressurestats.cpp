@@ -0,0 +1,86 @@
+#include "pressurestats.h"
+#include <algorithm>
+#include <math.h>
+
+void PressureStats::Summary::add(const Summary & other)
+{
+    loCount += other.loCount;
+    hiCount += other.hiCount;
+    loMeasured += other.loMeasured;
+    loCalculated += other.loCalculated;
+    hiMeasured += other.hiMeasured;
+    hiCalculated += other.hiCalculated;
+}
+
+double PressureStats::Summary::getLoError() const
+{
+    if (loCount <= 0) {
+        return 0;
+    }
+    return 100.0 * fabs(loMeasured - loCalculated) / loMeasured;
+}
+
+double PressureStats::Summary::getHiError() const
+{
+    if (hiCount <= 0) {
+        return 0;
+    }
+    return 100.0 * fabs(hiMeasured - hiCalculated) / hiMeasured;
+}
+
+void PressureStats::Series::clear()
+{
+    samples.clear();
+    measuredSums.assign(1, 0.0);
+    calculatedSums.assign(1, 0.0);
+}
+
+void PressureStats::Series::add(qint64 sampleIndex, double measured, double calculated)
+{
+    samples.push_back(sampleIndex);
+    measuredSums.push_back(measuredSums.back() + measured);
+    calculatedSums.push_back(calculatedSums.back() + calculated);
+}
+
+int PressureStats::Series::getRange(qint64 beginSample, qint64 endSample, double & measured, double & calculated) const
+{
+    if (samples.empty() || endSample <= beginSample) {
+        measured = 0;
+        calculated = 0;
+        return 0;
+    }
+    size_t begin = size_t(std::lower_bound(samples.begin(), samples.end(), beginSample) - samples.begin());
+    size_t end = size_t(std::lower_bound(samples.begin(), samples.end(), endSample) - samples.begin());
+    measured = measuredSums[end] - measuredSums[begin];
+    calculated = calculatedSums[end] - calculatedSums[begin];
+    return int(end - begin);
+}
+
+void PressureStats::clear()
+{
+    mLo.clear();
+    mHi.clear();
+}
+
+void PressureStats::build(const std::vector<qint64> & events,
+                          const std::vector<double> & minimums, const std::vector<double> & minimumsCalculated,
+                          const std::vector<double> & maximums, const std::vector<double> & maximumsCalculated)
+{
+    clear();
+    for (size_t i = 0; i < events.size(); i++) {
+        if (maximums[i] != 0 && maximumsCalculated[i] != 0) {
+            mHi.add(events[i], maximums[i], maximumsCalculated[i]);
+        }
+        if (minimums[i] != 0 && minimumsCalculated[i] != 0) {
+            mLo.add(events[i], minimums[i], minimumsCalculated[i]);
+        }
+    }
+}
+
+PressureStats::Summary PressureStats::getSummary(qint64 beginSample, qint64 endSample) const
+{
+    Summary summary;
+    summary.loCount = mLo.getRange(beginSample, endSample, summary.loMeasured, summary.loCalculated);
+    summary.hiCount = mHi.getRange(beginSample, endSample, summary.hiMeasured, summary.hiCalculated);
+    return summary;
+}
@@ -0,0 +1,64 @@
+#ifndef PRESSURESTATS_H
+#define PRESSURESTATS_H
+
+#include <QtGlobal>
+#include <vector>
+
+// статистика точности оценки давления по событиям канала АД
+// префиксные суммы измеренных и рассчитанных давлений строятся один раз после расчета,
+// сводка по любому диапазону отсчетов (область просмотра, окно калибровки, весь файл) - за O(log n)
+class PressureStats
+{
+public:
+    // сводка по диапазону
+    struct Summary {
+        // количество событий с измеренным и рассчитанным нижним/верхним давлением
+        int loCount;
+        int hiCount;
+        // суммы измеренных и рассчитанных давлений, ммрс
+        double loMeasured;
+        double loCalculated;
+        double hiMeasured;
+        double hiCalculated;
+
+        Summary() {
+            loCount = 0;
+            hiCount = 0;
+            loMeasured = 0;
+            loCalculated = 0;
+            hiMeasured = 0;
+            hiCalculated = 0;
+        }
+        // объединение сводок (например, по нескольким каналам)
+        void add(const Summary & other);
+        // относительная ошибка среднего рассчитанного давления по отношению к среднему измеренному того же типа, %
+        // (0 при отсутствии событий)
+        double getLoError() const;
+        double getHiError() const;
+    };
+
+    void clear();
+    // построение по давлениям в событиях канала (массивы того же размера, что events; 0 - нет значения)
+    void build(const std::vector<qint64> & events,
+               const std::vector<double> & minimums, const std::vector<double> & minimumsCalculated,
+               const std::vector<double> & maximums, const std::vector<double> & maximumsCalculated);
+    // сводка по отсчетам [beginSample, endSample)
+    Summary getSummary(qint64 beginSample, qint64 endSample) const;
+
+private:
+    // отсчеты событий и префиксные суммы (на один элемент больше количества событий)
+    struct Series {
+        std::vector<qint64> samples;
+        std::vector<double> measuredSums;
+        std::vector<double> calculatedSums;
+
+        void clear();
+        void add(qint64 sampleIndex, double measured, double calculated);
+        // количество и суммы событий в диапазоне
+        int getRange(qint64 beginSample, qint64 endSample, double & measured, double & calculated) const;
+    };
+    Series mLo;
+    Series mHi;
+};
+
+#endif // PRESSURESTATS_H
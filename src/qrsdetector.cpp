@@ -0,0 +1,290 @@
+#include "qrsdetector.h"
+#include <math.h>
+
+// полоса пропускания полосового фильтра, Гц
+#define QRS_LOW_CUTOFF_HZ 5.0
+#define QRS_HIGH_CUTOFF_HZ 15.0
+// окно скользящего интегрирования, мс
+#define QRS_INTEGRATION_MS 150.0
+// рефрактерный период, мс
+#define QRS_REFRACTORY_MS 200.0
+// период обучения порогов, мс
+#define QRS_LEARNING_MS 2000.0
+// длительность буфера входных отсчетов для поиска R-зубца, мс
+#define QRS_INPUT_BUFFER_MS 1000.0
+// повторный поиск пропущенного комплекса после паузы длиннее среднего RR в QRS_SEARCH_BACK_RR раз
+#define QRS_SEARCH_BACK_RR 1.66
+// количество интервалов RR для среднего
+#define QRS_RR_HISTORY 8
+
+BiquadFilter::BiquadFilter()
+{
+    // пропускает сигнал без изменений
+    mB0 = 1;
+    mB1 = 0;
+    mB2 = 0;
+    mA1 = 0;
+    mA2 = 0;
+    reset();
+}
+
+BiquadFilter BiquadFilter::lowPass(double sampleRate, double cutoffHz)
+{
+    // частота среза ограничивается частотой Найквиста
+    double w0 = 2.0 * M_PI * qMin(cutoffHz, 0.45 * sampleRate) / sampleRate;
+    double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    double a0 = 1.0 + alpha;
+    BiquadFilter filter;
+    filter.mB0 = (1.0 - cos(w0)) / 2.0 / a0;
+    filter.mB1 = (1.0 - cos(w0)) / a0;
+    filter.mB2 = filter.mB0;
+    filter.mA1 = -2.0 * cos(w0) / a0;
+    filter.mA2 = (1.0 - alpha) / a0;
+    return filter;
+}
+
+BiquadFilter BiquadFilter::highPass(double sampleRate, double cutoffHz)
+{
+    double w0 = 2.0 * M_PI * qMin(cutoffHz, 0.45 * sampleRate) / sampleRate;
+    double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    double a0 = 1.0 + alpha;
+    BiquadFilter filter;
+    filter.mB0 = (1.0 + cos(w0)) / 2.0 / a0;
+    filter.mB1 = -(1.0 + cos(w0)) / a0;
+    filter.mB2 = filter.mB0;
+    filter.mA1 = -2.0 * cos(w0) / a0;
+    filter.mA2 = (1.0 - alpha) / a0;
+    return filter;
+}
+
+void BiquadFilter::reset()
+{
+    mZ1 = 0;
+    mZ2 = 0;
+}
+
+double BiquadFilter::process(double value)
+{
+    double result = mB0 * value + mZ1;
+    mZ1 = mB1 * value - mA1 * result + mZ2;
+    mZ2 = mB2 * value - mA2 * result;
+    return result;
+}
+
+DerivativeFilter::DerivativeFilter(double sampleRate)
+{
+    mScale = sampleRate / 8.0;
+    reset();
+}
+
+void DerivativeFilter::reset()
+{
+    for (int i = 0; i < 4; i++) {
+        mHistory[i] = 0;
+    }
+}
+
+double DerivativeFilter::process(double value)
+{
+    double result = (2.0 * value + mHistory[0] - mHistory[2] - 2.0 * mHistory[3]) * mScale;
+    mHistory[3] = mHistory[2];
+    mHistory[2] = mHistory[1];
+    mHistory[1] = mHistory[0];
+    mHistory[0] = value;
+    return result;
+}
+
+QRSDetector::QRSDetector(double sampleRate) :
+    mIntegrator(qMax(1, int(sampleRate * QRS_INTEGRATION_MS / 1000.0))),
+    mBaseline(qMax(1, int(sampleRate)))
+{
+    mSampleRate = sampleRate;
+    mWindowSamples = mIntegrator.getWindowSize();
+    mRefractorySamples = qint64(sampleRate * QRS_REFRACTORY_MS / 1000.0);
+    mInput.assign(size_t(qMax(qint64(sampleRate * QRS_INPUT_BUFFER_MS / 1000.0), 4 * mWindowSamples)), 0.0);
+    reset();
+}
+
+void QRSDetector::reset()
+{
+    mHighPass = BiquadFilter::highPass(mSampleRate, QRS_LOW_CUTOFF_HZ);
+    mLowPass = BiquadFilter::lowPass(mSampleRate, QRS_HIGH_CUTOFF_HZ);
+    mDerivative = DerivativeFilter(mSampleRate);
+    mIntegrator.clear();
+    mBaseline.clear();
+    mNextIndex = 0;
+
+    mRising = true;
+    mPeakValue = 0;
+    mPeakIndex = 0;
+
+    mLearning = true;
+    mLearningSamples = 0;
+    mLearningMax = 0;
+    mLearningSum = 0;
+    mLearningCandidates.clear();
+
+    mSignalLevel = 0;
+    mNoiseLevel = 0;
+    mThreshold = 0;
+    mLastQRS = -1;
+    mAverageRR = 0;
+    mRecentRR.clear();
+    mHasSearchBack = false;
+}
+
+void QRSDetector::process(const double * pSamples, qint64 count, std::vector<qint64> & peaks)
+{
+    qint64 learningLength = qint64(mSampleRate * QRS_LEARNING_MS / 1000.0);
+    qint64 inputSize = qint64(mInput.size());
+    for (qint64 i = 0; i < count; i++) {
+        double value = pSamples[i];
+        qint64 index = mNextIndex++;
+        mInput[size_t(index % inputSize)] = value;
+        mBaseline.add(value);
+
+        // полосовой фильтр, производная, квадрат, интегрирование
+        double filtered = mLowPass.process(mHighPass.process(value));
+        double slope = mDerivative.process(filtered);
+        mIntegrator.add(slope * slope);
+        double integrated = mIntegrator.getMean();
+
+        if (mLearning) {
+            mLearningMax = qMax(mLearningMax, integrated);
+            mLearningSum += integrated;
+            mLearningSamples++;
+        }
+
+        // пик интегрированного сигнала фиксируется после спада ниже половины максимума
+        if (mRising) {
+            if (integrated > mPeakValue) {
+                mPeakValue = integrated;
+                mPeakIndex = index;
+            } else if (integrated < 0.5 * mPeakValue) {
+                Candidate candidate;
+                candidate.rIndex = findR(mPeakIndex);
+                candidate.value = mPeakValue;
+                mRising = false;
+                mPeakValue = integrated;
+                if (mLearning) {
+                    mLearningCandidates.push_back(candidate);
+                } else {
+                    classify(candidate, peaks);
+                }
+            }
+        } else if (integrated < mPeakValue) {
+            mPeakValue = integrated;
+        } else if (integrated > mPeakValue) {
+            mRising = true;
+            mPeakValue = integrated;
+            mPeakIndex = index;
+        }
+
+        if (mLearning && mLearningSamples >= learningLength) {
+            finishLearning(peaks);
+        }
+    }
+}
+
+void QRSDetector::finish(std::vector<qint64> & peaks)
+{
+    if (mRising && mPeakValue > 0) {
+        Candidate candidate;
+        candidate.rIndex = findR(mPeakIndex);
+        candidate.value = mPeakValue;
+        mRising = false;
+        if (mLearning) {
+            mLearningCandidates.push_back(candidate);
+        } else {
+            classify(candidate, peaks);
+        }
+    }
+    if (mLearning && mLearningSamples > 0) {
+        finishLearning(peaks);
+    }
+}
+
+qint64 QRSDetector::findR(qint64 peakIndex) const
+{
+    // R-зубец - наибольшее отклонение от базовой линии в двух окнах интегрирования до пика
+    // (задержка фильтров и интегрирования), в пределах буфера входных отсчетов
+    qint64 inputSize = qint64(mInput.size());
+    qint64 beginIndex = qMax(qMax(qint64(0), mNextIndex - inputSize), peakIndex - 2 * mWindowSamples);
+    qint64 endIndex = qMin(peakIndex + 1, mNextIndex);
+    double baseline = mBaseline.getMean();
+    qint64 rIndex = qMax(beginIndex, qMin(peakIndex, mNextIndex - 1));
+    double maxDeviation = -1;
+    for (qint64 index = beginIndex; index < endIndex; index++) {
+        double deviation = fabs(mInput[size_t(index % inputSize)] - baseline);
+        if (deviation > maxDeviation) {
+            maxDeviation = deviation;
+            rIndex = index;
+        }
+    }
+    return rIndex;
+}
+
+void QRSDetector::classify(const Candidate & candidate, std::vector<qint64> & peaks)
+{
+    // повторный поиск: после паузы длиннее QRS_SEARCH_BACK_RR средних RR комплексом считается
+    // наибольший шумовой пик выше половины порога
+    if (mLastQRS >= 0 && mAverageRR > 0 && mHasSearchBack &&
+            double(candidate.rIndex - mLastQRS) > QRS_SEARCH_BACK_RR * mAverageRR) {
+        if (mSearchBack.value > 0.5 * mThreshold) {
+            acceptQRS(mSearchBack, 0.25, peaks);
+        }
+        mHasSearchBack = false;
+    }
+
+    if (mLastQRS >= 0 && candidate.rIndex - mLastQRS < mRefractorySamples) {
+        return;
+    }
+    if (candidate.value > mThreshold) {
+        acceptQRS(candidate, 0.125, peaks);
+    } else {
+        mNoiseLevel = 0.125 * candidate.value + 0.875 * mNoiseLevel;
+        updateThreshold();
+        if (!mHasSearchBack || candidate.value > mSearchBack.value) {
+            mSearchBack = candidate;
+            mHasSearchBack = true;
+        }
+    }
+}
+
+void QRSDetector::acceptQRS(const Candidate & candidate, double weight, std::vector<qint64> & peaks)
+{
+    mSignalLevel = weight * candidate.value + (1.0 - weight) * mSignalLevel;
+    updateThreshold();
+    if (mLastQRS >= 0) {
+        mRecentRR.push_back(candidate.rIndex - mLastQRS);
+        if (mRecentRR.size() > QRS_RR_HISTORY) {
+            mRecentRR.erase(mRecentRR.begin());
+        }
+        double sum = 0;
+        for (qint64 rr : mRecentRR) {
+            sum += double(rr);
+        }
+        mAverageRR = sum / double(mRecentRR.size());
+    }
+    mLastQRS = candidate.rIndex;
+    mHasSearchBack = false;
+    peaks.push_back(candidate.rIndex);
+}
+
+void QRSDetector::finishLearning(std::vector<qint64> & peaks)
+{
+    mLearning = false;
+    mSignalLevel = 0.25 * mLearningMax;
+    mNoiseLevel = 0.5 * mLearningSum / double(mLearningSamples);
+    updateThreshold();
+    std::vector<Candidate> candidates;
+    candidates.swap(mLearningCandidates);
+    for (const Candidate & candidate : candidates) {
+        classify(candidate, peaks);
+    }
+}
+
+void QRSDetector::updateThreshold()
+{
+    mThreshold = mNoiseLevel + 0.25 * (mSignalLevel - mNoiseLevel);
+}
@@ -0,0 +1,120 @@
+#ifndef QRSDETECTOR_H
+#define QRSDETECTOR_H
+
+#include <QtGlobal>
+#include <vector>
+#include "rollingstatistics.h"
+
+// биквадратный IIR-фильтр (прямая форма II транспонированная), коэффициенты по формулам RBJ
+class BiquadFilter
+{
+public:
+    BiquadFilter();
+
+    // фильтр нижних/верхних частот 2-го порядка (Баттерворт) с частотой среза cutoffHz
+    static BiquadFilter lowPass(double sampleRate, double cutoffHz);
+    static BiquadFilter highPass(double sampleRate, double cutoffHz);
+
+    void reset();
+    double process(double value);
+
+private:
+    double mB0, mB1, mB2, mA1, mA2;
+    double mZ1, mZ2;
+};
+
+// пятиточечная производная: y[n] = (2x[n] + x[n-1] - x[n-3] - 2x[n-4]) * fs / 8
+class DerivativeFilter
+{
+public:
+    explicit DerivativeFilter(double sampleRate = 1.0);
+
+    void reset();
+    double process(double value);
+
+private:
+    double mScale;
+    // x[n-1] .. x[n-4]
+    double mHistory[4];
+};
+
+// потоковый детектор QRS по Пану-Томпкинсу:
+// полосовой фильтр 5..15 Гц -> производная -> возведение в квадрат -> скользящее интегрирование 150 мс ->
+// пики интегрированного сигнала с адаптивными порогами сигнала и шума, рефрактерным периодом и повторным
+// поиском пропущенного комплекса по среднему RR
+// отсчеты подаются блоками любого размера, состояние каждой ступени - O(1) (кольцевые буферы фиксированной длины)
+class QRSDetector
+{
+public:
+    explicit QRSDetector(double sampleRate);
+
+    void reset();
+    // обработка блока отсчетов; индексы найденных R-зубцов (от начала потока, по возрастанию) дописываются в peaks
+    void process(const double * pSamples, qint64 count, std::vector<qint64> & peaks);
+    // завершение потока: разбор последнего пика и пиков периода обучения, если поток короче него
+    void finish(std::vector<qint64> & peaks);
+
+private:
+    // пик интегрированного сигнала - кандидат в комплекс QRS
+    struct Candidate {
+        // отсчет R-зубца во входном сигнале
+        qint64 rIndex;
+        // значение интегрированного сигнала в пике
+        double value;
+    };
+
+    //
+    double mSampleRate;
+    // ступени обработки
+    BiquadFilter mHighPass;
+    BiquadFilter mLowPass;
+    DerivativeFilter mDerivative;
+    RollingStatistics mIntegrator;
+    // базовая линия входного сигнала для поиска R-зубца
+    RollingStatistics mBaseline;
+    // последние входные отсчеты (кольцевой буфер) для поиска R-зубца
+    std::vector<double> mInput;
+    // номер следующего входного отсчета
+    qint64 mNextIndex;
+
+    // поиск пика интегрированного сигнала: рост до максимума, затем спад ниже половины максимума
+    bool mRising;
+    double mPeakValue;
+    qint64 mPeakIndex;
+
+    // период обучения: максимум и сумма интегрированного сигнала, кандидаты до инициализации порогов
+    qint64 mLearningSamples;
+    double mLearningMax;
+    double mLearningSum;
+    std::vector<Candidate> mLearningCandidates;
+    bool mLearning;
+
+    // уровни пиков сигнала и шума, порог
+    double mSignalLevel;
+    double mNoiseLevel;
+    double mThreshold;
+    // последний комплекс QRS (-1 - еще не было) и средний RR по последним интервалам, отсчетов
+    qint64 mLastQRS;
+    double mAverageRR;
+    std::vector<qint64> mRecentRR;
+    // наибольший шумовой пик после последнего комплекса (для повторного поиска)
+    Candidate mSearchBack;
+    bool mHasSearchBack;
+
+    // рефрактерный период и длительность окна интегрирования, отсчетов
+    qint64 mRefractorySamples;
+    qint64 mWindowSamples;
+
+    // отсчет R-зубца для пика интегрированного сигнала в отсчете peakIndex
+    qint64 findR(qint64 peakIndex) const;
+    // разбор кандидата
+    void classify(const Candidate & candidate, std::vector<qint64> & peaks);
+    // принятие комплекса QRS
+    void acceptQRS(const Candidate & candidate, double weight, std::vector<qint64> & peaks);
+    // инициализация порогов по периоду обучения и разбор накопленных кандидатов
+    void finishLearning(std::vector<qint64> & peaks);
+    //
+    void updateThreshold();
+};
+
+#endif // QRSDETECTOR_H
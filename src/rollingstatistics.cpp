@@ -0,0 +1,116 @@
+#include "rollingstatistics.h"
+
+void RollingStatistics::MonotonicQueue::reset(int capacity)
+{
+    mIndexes.assign(size_t(capacity), 0);
+    mValues.assign(size_t(capacity), 0.0);
+    mCapacity = capacity;
+    mHead = 0;
+    mSize = 0;
+}
+
+void RollingStatistics::MonotonicQueue::pushBack(qint64 index, double value)
+{
+    int position = getPosition(mSize);
+    mIndexes[position] = index;
+    mValues[position] = value;
+    mSize++;
+}
+
+RollingStatistics::RollingStatistics(int windowSize)
+{
+    mWindowSize = qMax(1, windowSize);
+    mValues.assign(size_t(mWindowSize), 0.0);
+    clear();
+}
+
+void RollingStatistics::clear()
+{
+    mPosition = 0;
+    mNextIndex = 0;
+    mMinQueue.reset(mWindowSize);
+    mMaxQueue.reset(mWindowSize);
+    mMean = 0;
+    mSquaredDeviations = 0;
+}
+
+void RollingStatistics::add(double value)
+{
+    qint64 index = mNextIndex++;
+    // индекс, покидающий окно
+    qint64 expiredIndex = index - mWindowSize;
+
+    // очереди: вытесненный индекс снимается спереди, значения, которые уже не станут
+    // минимумом (максимумом) при наличии более нового value, снимаются сзади
+    if (!mMinQueue.isEmpty() && mMinQueue.frontIndex() <= expiredIndex) {
+        mMinQueue.popFront();
+    }
+    if (!mMaxQueue.isEmpty() && mMaxQueue.frontIndex() <= expiredIndex) {
+        mMaxQueue.popFront();
+    }
+    while (!mMinQueue.isEmpty() && mMinQueue.backValue() >= value) {
+        mMinQueue.popBack();
+    }
+    while (!mMaxQueue.isEmpty() && mMaxQueue.backValue() <= value) {
+        mMaxQueue.popBack();
+    }
+    mMinQueue.pushBack(index, value);
+    mMaxQueue.pushBack(index, value);
+
+    // среднее и сумма квадратов отклонений (по Уэлфорду, с вытеснением старого значения)
+    if (expiredIndex < 0) {
+        double delta = value - mMean;
+        mMean += delta / double(index + 1);
+        mSquaredDeviations += delta * (value - mMean);
+    } else {
+        double expiredValue = mValues[mPosition];
+        double previousMean = mMean;
+        mMean += (value - expiredValue) / double(mWindowSize);
+        mSquaredDeviations += (value - expiredValue) * (value - mMean + expiredValue - previousMean);
+        if (mSquaredDeviations < 0) {
+            mSquaredDeviations = 0;
+        }
+    }
+
+    mValues[mPosition] = value;
+    mPosition++;
+    if (mPosition == mWindowSize) {
+        mPosition = 0;
+    }
+}
+
+int RollingStatistics::getWindowSize() const
+{
+    return mWindowSize;
+}
+
+int RollingStatistics::getCount() const
+{
+    return int(qMin(mNextIndex, qint64(mWindowSize)));
+}
+
+bool RollingStatistics::isFull() const
+{
+    return mNextIndex >= mWindowSize;
+}
+
+double RollingStatistics::getMin() const
+{
+    return mMinQueue.frontValue();
+}
+
+double RollingStatistics::getMax() const
+{
+    return mMaxQueue.frontValue();
+}
+
+double RollingStatistics::getMean() const
+{
+    return mMean;
+}
+
+double RollingStatistics::getVariance() const
+{
+    int count = getCount();
+    return count > 0 ? mSquaredDeviations / double(count) : 0.0;
+}
@@ -0,0 +1,72 @@
+#ifndef ROLLINGSTATISTICS_H
+#define ROLLINGSTATISTICS_H
+
+#include <QtGlobal>
+#include <vector>
+
+// скользящие статистики по последним windowSize значениям потока
+// минимум и максимум - по монотонным очередям (амортизированно O(1) на значение),
+// среднее и дисперсия - обновлением при добавлении и вытеснении значения (O(1) на значение)
+class RollingStatistics
+{
+public:
+    explicit RollingStatistics(int windowSize = 1);
+
+    // сброс накопленных значений (размер окна сохраняется)
+    void clear();
+    // добавление значения; самое старое значение вытесняется, если окно заполнено
+    void add(double value);
+
+    // размер окна
+    int getWindowSize() const;
+    // количество значений в окне (не больше размера окна)
+    int getCount() const;
+    // окно заполнено
+    bool isFull() const;
+
+    // статистики по значениям окна (окно не должно быть пустым)
+    double getMin() const;
+    double getMax() const;
+    double getMean() const;
+    // дисперсия (смещенная, деление на количество значений)
+    double getVariance() const;
+
+private:
+    // монотонная очередь значений с номерами в кольцевом буфере фиксированной емкости
+    class MonotonicQueue {
+    public:
+        void reset(int capacity);
+        bool isEmpty() const { return mSize == 0; }
+        qint64 frontIndex() const { return mIndexes[mHead]; }
+        double frontValue() const { return mValues[mHead]; }
+        double backValue() const { return mValues[getPosition(mSize - 1)]; }
+        void popFront() { mHead = getPosition(1); mSize--; }
+        void popBack() { mSize--; }
+        void pushBack(qint64 index, double value);
+
+    private:
+        std::vector<qint64> mIndexes;
+        std::vector<double> mValues;
+        int mCapacity;
+        int mHead;
+        int mSize;
+        // позиция в буфере со смещением offset от начала очереди (без деления по модулю)
+        int getPosition(int offset) const { int position = mHead + offset; return position >= mCapacity ? position - mCapacity : position; }
+    };
+
+    //
+    int mWindowSize;
+    // последние значения потока (кольцевой буфер) и позиция следующего значения в нем
+    std::vector<double> mValues;
+    int mPosition;
+    // номер следующего значения потока
+    qint64 mNextIndex;
+    // кандидаты в минимум (значения по возрастанию) и максимум (по убыванию)
+    MonotonicQueue mMinQueue;
+    MonotonicQueue mMaxQueue;
+    // среднее и сумма квадратов отклонений от среднего
+    double mMean;
+    double mSquaredDeviations;
+};
+
+#endif // ROLLINGSTATISTICS_H
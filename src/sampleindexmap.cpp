@@ -0,0 +1,26 @@
+#include "sampleindexmap.h"
+
+SampleIndexMap::SampleIndexMap()
+{
+    mNum = 1;
+    mDen = 1;
+}
+
+SampleIndexMap::SampleIndexMap(qint64 fromSamplesInRecord, qint64 toSamplesInRecord)
+{
+    if (fromSamplesInRecord <= 0 || toSamplesInRecord <= 0) {
+        mNum = 1;
+        mDen = 1;
+        return;
+    }
+    // сокращение дроби (алгоритм Евклида)
+    qint64 a = fromSamplesInRecord;
+    qint64 b = toSamplesInRecord;
+    while (b != 0) {
+        qint64 r = a % b;
+        a = b;
+        b = r;
+    }
+    mNum = toSamplesInRecord / a;
+    mDen = fromSamplesInRecord / a;
+}
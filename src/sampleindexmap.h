@@ -0,0 +1,34 @@
+#ifndef SAMPLEINDEXMAP_H
+#define SAMPLEINDEXMAP_H
+
+#include <QtGlobal>
+
+// отображение индексов отсчетов одного канала в индексы другого канала
+// длительность записи данных (datarecord) у всех каналов EDF общая, поэтому частоты
+// каналов соотносятся как smp_in_datarecord, и отображение задается несократимой
+// дробью mNum / mDen в целых числах, без плавающей точки
+class SampleIndexMap
+{
+public:
+    SampleIndexMap();
+    SampleIndexMap(qint64 fromSamplesInRecord, qint64 toSamplesInRecord);
+
+    // индекс отсчета в канале назначения, не позже по времени отсчета index
+    qint64 map(qint64 index) const { return index * mNum / mDen; }
+    // наименьший индекс отсчета в канале назначения, не раньше по времени отсчета index
+    qint64 mapCeil(qint64 index) const { return (index * mNum + mDen - 1) / mDen; }
+    // обратное отображение (из канала назначения в исходный канал)
+    qint64 unmap(qint64 index) const { return index * mDen / mNum; }
+
+private:
+    qint64 mNum;
+    qint64 mDen;
+};
+
+// индекс отсчета, соответствующий проценту от длительности канала (умножение в 64 битах)
+inline qint64 percentToIndex(int percent, qint64 samplesCount)
+{
+    return qint64(percent) * samplesCount / 100;
+}
+
+#endif // SAMPLEINDEXMAP_H
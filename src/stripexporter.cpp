@@ -0,0 +1,189 @@
+#include "stripexporter.h"
+#include "edfreader.h"
+#include "waveformrenderer.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <math.h>
+#include <stdio.h>
+
+// ключ пакетного режима
+#define EXPORT_OPTION "--export"
+// объем кэша плиток одного потока, Кб (полосы не перекрываются, кэш почти не используется повторно)
+#define EXPORT_TILE_CACHE_KB (16 * 1024)
+// пропуск пустых частей при разборе списка каналов (QString::SkipEmptyParts устарел с Qt 5.14)
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+#define EXPORT_SKIP_EMPTY_PARTS Qt::SkipEmptyParts
+#else
+#define EXPORT_SKIP_EMPTY_PARTS QString::SkipEmptyParts
+#endif
+
+bool StripExporter::isRequested(int argc, char * argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], EXPORT_OPTION) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StripExporter::parseArguments(const QStringList & arguments, Options & options)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ECGViewer batch export of signal strips to PNG");
+    parser.addHelpOption();
+    QCommandLineOption exportOption("export", "EDF file to export.", "file");
+    QCommandLineOption outOption("out", "Output directory.", "dir", ".");
+    QCommandLineOption channelsOption("channels", "Comma separated channel indexes (default all).", "list");
+    QCommandLineOption fromOption("from", "Start of the exported range, s.", "seconds", "0");
+    QCommandLineOption toOption("to", "End of the exported range, s (default end of recording).", "seconds", "-1");
+    QCommandLineOption stepOption("step", "Duration of one strip, s.", "seconds", "10");
+    QCommandLineOption heightOption("height", "Height of one channel, px.", "pixels", "150");
+    QCommandLineOption sweepOption("sweep", "Sweep factor.", "factor", "30");
+    QCommandLineOption scaleOption("scale", "Scaling factor.", "factor", "1000");
+    QCommandLineOption threadsOption("threads", "Worker threads (default all cores).", "count", "0");
+    parser.addOptions({exportOption, outOption, channelsOption, fromOption, toOption, stepOption,
+                       heightOption, sweepOption, scaleOption, threadsOption});
+    parser.process(arguments);
+
+    options.fileName = parser.value(exportOption);
+    options.outputDir = parser.value(outOption);
+    options.channels.clear();
+    if (parser.isSet(channelsOption)) {
+        for (const QString & text : parser.value(channelsOption).split(',', EXPORT_SKIP_EMPTY_PARTS)) {
+            bool ok = false;
+            int channel = text.trimmed().toInt(&ok);
+            if (!ok || channel < 0) {
+                printf("error: bad channel index '%s'\n", qPrintable(text));
+                return false;
+            }
+            options.channels.append(channel);
+        }
+    }
+    options.beginS = parser.value(fromOption).toDouble();
+    options.endS = parser.value(toOption).toDouble();
+    options.stepS = parser.value(stepOption).toDouble();
+    options.channelHeight = parser.value(heightOption).toInt();
+    options.sweepFactor = parser.value(sweepOption).toDouble();
+    options.scalingFactor = parser.value(scaleOption).toDouble();
+    options.threads = parser.value(threadsOption).toInt();
+
+    if (options.fileName.isEmpty() || options.stepS <= 0 || options.channelHeight <= 0 ||
+            options.sweepFactor <= 0 || options.scalingFactor <= 0) {
+        printf("error: bad arguments\n");
+        return false;
+    }
+    return true;
+}
+
+bool StripExporter::load(const Options & options, edf_hdr_struct & header, QVector<ChannelParams> & channels)
+{
+    QScopedPointer<edf_hdr_struct> pFileHeader(new edf_hdr_struct);
+    if (edfopen_file_readonly(options.fileName.toLocal8Bit().data(), pFileHeader.data(), EDFLIB_DO_NOT_READ_ANNOTATIONS)) {
+        printf("error: can not open file %s (%d)\n", qPrintable(options.fileName), pFileHeader->filetype);
+        return false;
+    }
+
+    QVector<int> fileChannels = options.channels;
+    if (fileChannels.isEmpty()) {
+        for (int channel = 0; channel < pFileHeader->edfsignals; channel++) {
+            fileChannels.append(channel);
+        }
+    }
+
+    // заголовок только с выбранными каналами
+    header = *pFileHeader;
+    header.edfsignals = fileChannels.size();
+    channels.resize(fileChannels.size());
+    for (int i = 0; i < fileChannels.size(); i++) {
+        int fileChannel = fileChannels[i];
+        if (fileChannel >= pFileHeader->edfsignals) {
+            printf("error: no channel %d in file\n", fileChannel);
+            edfclose_file(pFileHeader->handle);
+            return false;
+        }
+        header.signalparam[i] = pFileHeader->signalparam[fileChannel];
+
+        std::vector<double> samples;
+        if (!EDFReader::readPhysicalSamples(pFileHeader->handle, fileChannel, pFileHeader->signalparam[fileChannel].smp_in_file, samples)) {
+            edfclose_file(pFileHeader->handle);
+            return false;
+        }
+        channels[i].setSamples(quint32(i), std::move(samples));
+    }
+    edfclose_file(pFileHeader->handle);
+    return header.edfsignals > 0;
+}
+
+int StripExporter::run(const Options & options)
+{
+    QScopedPointer<edf_hdr_struct> pHeader(new edf_hdr_struct);
+    QVector<ChannelParams> channels;
+    if (!load(options, *pHeader, channels)) {
+        return 1;
+    }
+    if (!QDir().mkpath(options.outputDir)) {
+        printf("error: can not create directory %s\n", qPrintable(options.outputDir));
+        return 1;
+    }
+
+    // интервалы полос по опорному каналу 0
+    double durationS = double(pHeader->signalparam[0].smp_in_file) / WaveformRenderer::getSampleRate(pHeader.data(), 0);
+    double endS = options.endS < 0 ? durationS : qMin(options.endS, durationS);
+    double pixelsPerSecond = WaveformRenderer::getPixelsPerSecond(options.sweepFactor);
+    int stripWidth = int(ceil(options.stepS * pixelsPerSecond));
+    qint64 stripCount = options.beginS < endS ? qint64(ceil((endS - options.beginS) / options.stepS)) : 0;
+    QString baseName = QFileInfo(options.fileName).completeBaseName();
+
+    ViewParams view;
+    view.size = QSize(stripWidth, options.channelHeight * pHeader->edfsignals);
+    view.sweepFactor = options.sweepFactor;
+    view.scalingFactors.fill(options.scalingFactor, channels.size());
+    // без расчета каналы ЭКГ и плетизмограммы не выделяются цветом
+    view.channelECG = -1;
+    view.channelPlethism = -1;
+    view.showStats = false;
+
+    // полосы делятся на непрерывные части по числу потоков, у каждого потока свой рендерер
+    QThreadPool pool;
+    int threads = options.threads > 0 ? options.threads : QThread::idealThreadCount();
+    pool.setMaxThreadCount(threads);
+    qint64 partSize = (stripCount + threads - 1) / qMax(1, threads);
+    QAtomicInt failedCount(0);
+    const edf_hdr_struct * pConstHeader = pHeader.data();
+    const QVector<ChannelParams> * pChannels = &channels;
+
+    QVector<QFuture<void>> futures;
+    for (qint64 partBegin = 0; partBegin < stripCount; partBegin += partSize) {
+        qint64 partEnd = qMin(stripCount, partBegin + partSize);
+        futures.append(QtConcurrent::run(&pool, [=, &failedCount, &options]() {
+            WaveformRenderer renderer;
+            renderer.setTileCacheSize(EXPORT_TILE_CACHE_KB);
+            renderer.setData(pConstHeader, pChannels);
+            ViewParams stripView = view;
+            for (qint64 strip = partBegin; strip < partEnd; strip++) {
+                double stripBeginS = options.beginS + double(strip) * options.stepS;
+                stripView.startPixel = qint64(floor(stripBeginS * pixelsPerSecond + 0.5));
+                QImage image = renderer.renderFrame(stripView);
+                QString path = QDir(options.outputDir).filePath(
+                            QString("%1_%2.png").arg(baseName).arg(strip, 6, 10, QChar('0')));
+                if (!image.save(path, "PNG")) {
+                    printf("error: can not save %s\n", qPrintable(path));
+                    failedCount.ref();
+                }
+            }
+        }));
+    }
+    for (int i = 0; i < futures.size(); i++) {
+        futures[i].waitForFinished();
+    }
+
+    printf("exported %lld strips, %d failed\n", stripCount, int(failedCount.load()));
+    return failedCount.load() == 0 ? 0 : 1;
+}
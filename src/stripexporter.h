@@ -0,0 +1,60 @@
+#ifndef STRIPEXPORTER_H
+#define STRIPEXPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "EDFlib/edflib.h"
+#include "channelparams.h"
+
+// пакетная отрисовка полос сигналов в PNG без окна (платформа offscreen)
+// запись разбивается на интервалы по stepS секунд, каждый интервал сохраняется отдельным файлом;
+// используется тот же WaveformRenderer, что и в виджете, полосы распределяются по всем ядрам
+class StripExporter
+{
+public:
+    struct Options {
+        // файл EDF
+        QString fileName;
+        // каталог для PNG
+        QString outputDir;
+        // индексы каналов (пусто - все каналы)
+        QVector<int> channels;
+        // начало и конец интервала, с (endS < 0 - до конца записи)
+        double beginS;
+        double endS;
+        // длительность одной полосы, с
+        double stepS;
+        // высота полосы одного канала, пикс
+        int channelHeight;
+        // разрешение по времени
+        qreal sweepFactor;
+        // масштабирующий коэффициент
+        qreal scalingFactor;
+        // количество потоков (0 - по количеству ядер)
+        int threads;
+
+        Options() {
+            beginS = 0;
+            endS = -1;
+            stepS = 10;
+            channelHeight = 150;
+            sweepFactor = 30.0;
+            scalingFactor = 1000.0;
+            threads = 0;
+        }
+    };
+
+    // запрошен ли пакетный режим (до создания приложения, платформа выбирается заранее)
+    static bool isRequested(int argc, char * argv[]);
+    // разбор аргументов командной строки
+    static bool parseArguments(const QStringList & arguments, Options & options);
+    // отрисовка и сохранение полос, код завершения процесса
+    static int run(const Options & options);
+
+private:
+    // чтение выбранных каналов; header содержит только выбранные каналы в порядке options.channels
+    static bool load(const Options & options, edf_hdr_struct & header, QVector<ChannelParams> & channels);
+};
+
+#endif // STRIPEXPORTER_H
@@ -0,0 +1,93 @@
+#include "timeaxismapper.h"
+#include <math.h>
+
+// таблица интервалов между метками, мс
+static const qint64 niceIntervalsMs[] = {
+    100, 200, 500,
+    1000, 2000, 5000, 10000, 15000, 30000,
+    60000, 120000, 300000, 600000, 900000, 1800000,
+    3600000, 7200000, 10800000, 21600000, 43200000, 86400000
+};
+
+// длительность суток, мс
+static const qint64 dayMs = 86400000;
+
+TimeAxisMapper::TimeAxisMapper()
+{
+    mStartOfDayMs = 0;
+    mMsPerPixel = 1;
+    mIntervalMs = niceIntervalsMs[0];
+}
+
+void TimeAxisMapper::setup(double startOfDayMs, double msPerPixel, int minPixelsPerTick)
+{
+    mStartOfDayMs = startOfDayMs;
+    mMsPerPixel = msPerPixel > 0 ? msPerPixel : 1;
+
+    // наименьший интервал из таблицы, дающий не менее minPixelsPerTick между метками
+    int count = int(sizeof(niceIntervalsMs) / sizeof(niceIntervalsMs[0]));
+    mIntervalMs = niceIntervalsMs[count - 1];
+    for (int i = 0; i < count; i++) {
+        if (double(niceIntervalsMs[i]) / mMsPerPixel >= double(minPixelsPerTick)) {
+            mIntervalMs = niceIntervalsMs[i];
+            break;
+        }
+    }
+}
+
+qint64 TimeAxisMapper::getIntervalMs() const
+{
+    return mIntervalMs;
+}
+
+double TimeAxisMapper::pixelToMs(qint64 pixel) const
+{
+    return double(pixel) * mMsPerPixel;
+}
+
+qint64 TimeAxisMapper::msToPixel(double ms) const
+{
+    return qint64(ceil(ms / mMsPerPixel));
+}
+
+qint64 TimeAxisMapper::pixelToTimeOfDayMs(qint64 pixel) const
+{
+    qint64 timeMs = qint64(floor(mStartOfDayMs + pixelToMs(pixel)));
+    return ((timeMs % dayMs) + dayMs) % dayMs;
+}
+
+void TimeAxisMapper::getTicks(qint64 beginPixel, qint64 endPixel, QVector<Tick> & ticks) const
+{
+    // resize не уменьшает емкость, поэтому повторные вызовы не выделяют память
+    ticks.resize(0);
+    if (endPixel <= beginPixel) {
+        return;
+    }
+    // первая метка не раньше beginPixel (время отсчитывается от начала суток начала записи)
+    double beginMs = mStartOfDayMs + pixelToMs(beginPixel);
+    qint64 tickIndex = qint64(ceil(beginMs / double(mIntervalMs)));
+    for (;; tickIndex++) {
+        double tickMs = double(tickIndex * mIntervalMs);
+        qint64 pixel = msToPixel(tickMs - mStartOfDayMs);
+        if (pixel < beginPixel) continue;
+        if (pixel >= endPixel) break;
+        Tick tick;
+        tick.pixel = pixel;
+        tick.timeOfDayMs = ((tickIndex * mIntervalMs) % dayMs + dayMs) % dayMs;
+        ticks.append(tick);
+    }
+}
+
+QString TimeAxisMapper::formatTime(qint64 timeOfDayMs, int fractionDigits)
+{
+    timeOfDayMs = ((timeOfDayMs % dayMs) + dayMs) % dayMs;
+    int ms = int(timeOfDayMs % 1000);
+    int seconds = int(timeOfDayMs / 1000);
+    QString text = QString::asprintf("%02d:%02d:%02d", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    switch (fractionDigits) {
+    case 1: return text + QString::asprintf(".%01d", ms / 100);
+    case 2: return text + QString::asprintf(".%02d", ms / 10);
+    case 3: return text + QString::asprintf(".%03d", ms);
+    default: return text;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TIMEAXISMAPPER_H
+#define TIMEAXISMAPPER_H
+
+#include <QString>
+#include <QVector>
+
+// соответствие пикселей оси времени и времени суток без QDateTime
+// положения меток и подписи вычисляются арифметически по частоте дискретизации,
+// времени начала записи (с долями секунды) и таблице "круглых" интервалов;
+// используется для линеек времени, а также для измерений и экспорта
+class TimeAxisMapper
+{
+public:
+    struct Tick {
+        // абсолютная координата метки, пикс (от начала записи)
+        qint64 pixel;
+        // время метки от начала суток, мс
+        qint64 timeOfDayMs;
+    };
+
+    TimeAxisMapper();
+
+    // startOfDayMs время начала записи от начала суток, мс
+    // msPerPixel длительность одного пикселя, мс
+    // minPixelsPerTick минимальное расстояние между метками, пикс
+    void setup(double startOfDayMs, double msPerPixel, int minPixelsPerTick);
+    // интервал между метками, мс
+    qint64 getIntervalMs() const;
+    // время от начала записи для абсолютной координаты, мс
+    double pixelToMs(qint64 pixel) const;
+    // абсолютная координата для времени от начала записи, пикс
+    qint64 msToPixel(double ms) const;
+    // время суток для абсолютной координаты, мс
+    qint64 pixelToTimeOfDayMs(qint64 pixel) const;
+    // метки с координатами [beginPixel, endPixel) в ticks (емкость ticks сохраняется между вызовами)
+    void getTicks(qint64 beginPixel, qint64 endPixel, QVector<Tick> & ticks) const;
+    // подпись времени суток "hh:mm:ss" с fractionDigits знаками долей секунды (0..3)
+    static QString formatTime(qint64 timeOfDayMs, int fractionDigits);
+
+private:
+    double mStartOfDayMs;
+    double mMsPerPixel;
+    qint64 mIntervalMs;
+};
+
+#endif // TIMEAXISMAPPER_H
@@ -0,0 +1,89 @@
+#include "timelagmatcher.h"
+#include "peakdetector.h"
+#include <string.h>
+
+TimeLagMatcher::TimeLagMatcher()
+{
+    // задержка не больше периода при минимальной ЧСС (в целых секундах, как в исходном расчете)
+    mMinLagS = 0;
+    mMaxLagS = int(60.0 / MIN_HEART_RATE);
+    mFiducial = FIDUCIAL_PEAK;
+}
+
+void TimeLagMatcher::setLagRange(double minLagS, double maxLagS)
+{
+    mMinLagS = minLagS;
+    mMaxLagS = maxLagS;
+}
+
+void TimeLagMatcher::setFiducial(int fiducial)
+{
+    mFiducial = fiducial;
+}
+
+std::vector<qint64> TimeLagMatcher::extractPeaks(const int * pHeartRate, qint64 samplesCount)
+{
+    std::vector<qint64> peaks;
+    for (qint64 sampleIndex = 0; sampleIndex < samplesCount; sampleIndex++) {
+        if (pHeartRate[sampleIndex] > 0) {
+            peaks.push_back(sampleIndex);
+        }
+    }
+    return peaks;
+}
+
+std::vector<qint64> TimeLagMatcher::getFiducials(const std::vector<qint64> & peaksP, const double * pSamplesP) const
+{
+    if (mFiducial == FIDUCIAL_PEAK) {
+        return peaksP;
+    }
+    std::vector<qint64> fiducials(peaksP.size());
+    qint64 previousPeak = 0;
+    for (size_t i = 0; i < peaksP.size(); i++) {
+        qint64 peak = peaksP[i];
+        // основание волны: минимум после предыдущего пика
+        qint64 foot = peak;
+        for (qint64 sampleIndex = previousPeak; sampleIndex < peak; sampleIndex++) {
+            if (pSamplesP[sampleIndex] < pSamplesP[foot]) {
+                foot = sampleIndex;
+            }
+        }
+        fiducials[i] = foot;
+        if (mFiducial == FIDUCIAL_MAX_SLOPE) {
+            double maxSlope = 0;
+            for (qint64 sampleIndex = foot + 1; sampleIndex <= peak; sampleIndex++) {
+                double slope = pSamplesP[sampleIndex] - pSamplesP[sampleIndex - 1];
+                if (slope > maxSlope) {
+                    maxSlope = slope;
+                    fiducials[i] = sampleIndex;
+                }
+            }
+        }
+        previousPeak = peak;
+    }
+    return fiducials;
+}
+
+void TimeLagMatcher::match(const std::vector<qint64> & peaksECG, double sampleRateECG,
+                           const std::vector<qint64> & peaksP, const double * pSamplesP, double sampleRateP,
+                           double * pTimeLag, qint64 samplesCountP) const
+{
+    memset(pTimeLag, 0, sizeof(double) * samplesCountP);
+    std::vector<qint64> fiducials = getFiducials(peaksP, pSamplesP);
+
+    // время R-зубцов растет, поэтому первая подходящая волна не сдвигается назад
+    size_t indexP = 0;
+    for (qint64 indexECG : peaksECG) {
+        double timeECG = double(indexECG) / sampleRateECG;
+        while (indexP < fiducials.size() && !(double(fiducials[indexP]) / sampleRateP - timeECG > mMinLagS)) {
+            indexP++;
+        }
+        if (indexP == fiducials.size()) {
+            break;
+        }
+        double lag = double(fiducials[indexP]) / sampleRateP - timeECG;
+        if (lag < mMaxLagS) {
+            pTimeLag[peaksP[indexP]] = lag;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef TIMELAGMATCHER_H
+#define TIMELAGMATCHER_H
+
+#include <QtGlobal>
+#include <vector>
+
+// опорная точка пульсовой волны плетизмограммы
+// вершина (отмеченный пик)
+#define FIDUCIAL_PEAK 0
+// основание (минимум между предыдущим и текущим пиком)
+#define FIDUCIAL_FOOT 1
+// наибольшая крутизна подъема между основанием и вершиной
+#define FIDUCIAL_MAX_SLOPE 2
+
+// сопоставление R-зубцов ЭКГ и пульсовых волн плетизмограммы по отсортированным спискам пиков
+// для каждого R-зубца берется первая опорная точка плетизмограммы с задержкой больше minLag;
+// задержка записывается в отсчет пика плетизмограммы, если она меньше maxLag
+// (при нескольких R-зубцах на одну волну остается задержка от последнего)
+class TimeLagMatcher
+{
+public:
+    TimeLagMatcher();
+
+    // допустимый диапазон задержки, с
+    void setLagRange(double minLagS, double maxLagS);
+    // опорная точка пульсовой волны (FIDUCIAL_PEAK, FIDUCIAL_FOOT, FIDUCIAL_MAX_SLOPE)
+    void setFiducial(int fiducial);
+
+    // отсчеты с ненулевой ЧСС (по возрастанию)
+    static std::vector<qint64> extractPeaks(const int * pHeartRate, qint64 samplesCount);
+    // сопоставление за O(количество пиков) двумя указателями; pTimeLag обнуляется и заполняется
+    // в отсчетах пиков плетизмограммы peaksP, опорные точки считаются по отсчетам pSamplesP
+    void match(const std::vector<qint64> & peaksECG, double sampleRateECG,
+               const std::vector<qint64> & peaksP, const double * pSamplesP, double sampleRateP,
+               double * pTimeLag, qint64 samplesCountP) const;
+
+private:
+    //
+    double mMinLagS;
+    double mMaxLagS;
+    //
+    int mFiducial;
+
+    // опорные точки волн для пиков плетизмограммы
+    std::vector<qint64> getFiducials(const std::vector<qint64> & peaksP, const double * pSamplesP) const;
+};
+
+#endif // TIMELAGMATCHER_H
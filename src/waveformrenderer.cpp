@@ -0,0 +1,864 @@
+#include "waveformrenderer.h"
+#include <QPainter>
+#include <QFontMetrics>
+#include <QTime>
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// ширина плитки кэша отрисовки, пикс
+#define TILE_WIDTH 256
+// запас слева от плитки для подписей, начинающихся в предыдущей плитке, пикс
+#define TILE_LABEL_MARGIN 160
+// ширина области подписей значений сетки, пикс
+#define AXIS_LABEL_WIDTH 100
+// блок статистики в правом верхнем углу
+#define STATS_BOX_WIDTH 250
+#define STATS_BOX_HEIGHT 120
+// объем кэша плиток, Кб
+#define TILE_CACHE_KB (128 * 1024)
+// минимальный промежуток между подписями событий в строке, пикс
+#define LABEL_SPACING 4
+// количество кэшируемых разметок подписей
+#define LABEL_LAYOUT_CACHE_SIZE 20000
+// шаг столбцов грубого приближения плитки, пикс
+#define COARSE_COLUMN_STEP 4
+// наименьшее среднее расстояние между маркерами, при котором они выводятся по отдельности, пикс
+#define MARKER_MIN_SPACING 4
+// ширина полосы сводки событий при плотном расположении маркеров, пикс (делитель TILE_WIDTH)
+#define MARKER_BAND_WIDTH 64
+// высота полосы сводки событий, пикс
+#define MARKER_BAND_HEIGHT 12
+
+// масштаб по амплитуде
+#define MAGIC_POWER_SCALER 5.0
+// масштаб по времени
+#define MAGIC_TIME_SCALER 0.25
+
+WaveformRenderer::WaveformRenderer()
+{
+    mpEDFHeader = nullptr;
+    mpChannels = nullptr;
+    mTileChannelHeight = 0;
+    mFrameValid = false;
+    mFrameStartPixel = 0;
+    mFrameFirstChannel = 0;
+    mCoarseFallback = false;
+    mFrameComplete = true;
+    mCoarseTileCount = 0;
+    mTileCache.setMaxCost(TILE_CACHE_KB);
+    mLabelLayouts.setMaxCost(LABEL_LAYOUT_CACHE_SIZE);
+}
+
+void WaveformRenderer::setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels)
+{
+    mpEDFHeader = pEDFHeader;
+    mpChannels = pChannels;
+    invalidateTiles();
+}
+
+QImage WaveformRenderer::renderFrame(const ViewParams & view)
+{
+    bool contentChanged = isTileContentChanged(view);
+    mView = view;
+    if (contentChanged) {
+        invalidateTiles();
+    }
+    if (mView.size.isEmpty()) {
+        return QImage();
+    }
+
+    // уточнение предыдущего неполного кадра без изменения вида
+    qint32 previousCoarseTiles = -1;
+    if (!mFrameComplete && !contentChanged && mFrame.size() == mView.size &&
+            mpEDFHeader != nullptr && mpEDFHeader->edfsignals > 0 && getStartPixel() == mFrameStartPixel &&
+            mView.firstChannel == mFrameFirstChannel) {
+        previousCoarseTiles = mCoarseTileCount;
+    }
+
+    // кадр перерисовывается целиком при изменениях содержимого и прокрутке по вертикали
+    // (плитки берутся из кэша), при горизонтальной прокрутке предыдущий кадр сдвигается
+    if (!mFrameValid || mFrame.size() != mView.size || mView.firstChannel != mFrameFirstChannel) {
+        renderRegion(QRegion());
+        mFrameValid = true;
+    } else if (mpEDFHeader != nullptr && mpEDFHeader->edfsignals > 0 &&
+               getStartPixel() != mFrameStartPixel) {
+        scrollFrame();
+    }
+    if (!mFrameComplete && previousCoarseTiles >= 0 && mCoarseTileCount >= previousCoarseTiles) {
+        // уточнение не продвигается (плитки кадра не помещаются в кэш), кадр отрисовывается без бюджета
+        mView.frameBudgetMs = 0;
+        renderRegion(QRegion());
+    }
+    // кадр с грубыми плитками при следующем вызове перерисовывается целиком:
+    // готовые плитки берутся из кэша, оставшиеся уточняются в пределах бюджета
+    if (!mFrameComplete) {
+        mFrameValid = false;
+    }
+    return mFrame;
+}
+
+bool WaveformRenderer::isFrameComplete() const
+{
+    return mFrameComplete;
+}
+
+void WaveformRenderer::setTileCacheSize(int kilobytes)
+{
+    mTileCache.setMaxCost(kilobytes);
+}
+
+bool WaveformRenderer::isTileContentChanged(const ViewParams & view) const
+{
+    return view.contentGeneration != mView.contentGeneration ||
+            view.sweepFactor != mView.sweepFactor ||
+            view.scalingFactors != mView.scalingFactors ||
+            view.channelECG != mView.channelECG ||
+            view.channelPlethism != mView.channelPlethism ||
+            view.font != mView.font ||
+            view.aHi != mView.aHi || view.aLo != mView.aLo ||
+            view.bHi != mView.bHi || view.bLo != mView.bLo || view.n != mView.n ||
+            view.showStats != mView.showStats;
+}
+
+QStaticText WaveformRenderer::getLabelLayout(const QString & text, const QFont & font)
+{
+    // одинаковые подписи (значения ЧСС, давлений) повторяются, разметка кэшируется по тексту
+    QStaticText * pLayout = mLabelLayouts.object(text);
+    if (pLayout == nullptr) {
+        pLayout = new QStaticText(text);
+        pLayout->setTextFormat(Qt::PlainText);
+        pLayout->prepare(QTransform(), font);
+        QStaticText layout = *pLayout;
+        mLabelLayouts.insert(text, pLayout);
+        return layout;
+    }
+    return *pLayout;
+}
+
+void WaveformRenderer::scrollFrame()
+{
+    qint64 startPixel = getStartPixel();
+    qint64 delta = startPixel - mFrameStartPixel;
+    qint32 screenWidth = mView.size.width();
+    if (qAbs(delta) >= screenWidth) {
+        renderRegion(QRegion());
+        return;
+    }
+
+    // сдвиг уже отрисованных столбцов кадра на delta пикселей
+    int shift = int(qAbs(delta));
+    int bytesPerPixel = mFrame.depth() / 8;
+    int movedBytes = (screenWidth - shift) * bytesPerPixel;
+    for (int y = 0; y < mFrame.height(); y++) {
+        uchar * pLine = mFrame.scanLine(y);
+        if (delta > 0) {
+            memmove(pLine, pLine + shift * bytesPerPixel, size_t(movedBytes));
+        } else {
+            memmove(pLine + shift * bytesPerPixel, pLine, size_t(movedBytes));
+        }
+    }
+
+    // перерисовываются открывшиеся столбцы, а также неподвижные относительно окна
+    // подписи сетки и блок статистики (они сдвинулись вместе с кадром);
+    // подписи событий, пересекающие границу, берутся из плиток целиком и совпадают с полной отрисовкой
+    QRegion region;
+    if (delta > 0) {
+        region += QRect(screenWidth - shift, 0, shift, mView.size.height());
+    } else {
+        region += QRect(0, 0, shift, mView.size.height());
+    }
+    region += QRect(0, 0, AXIS_LABEL_WIDTH, mView.size.height());
+    if (mView.showStats) {
+        region += getStatsBoxRect();
+    }
+    renderRegion(region);
+}
+
+QRect WaveformRenderer::getStatsBoxRect()
+{
+    return QRect(mView.size.width() - STATS_BOX_WIDTH, 0, STATS_BOX_WIDTH, STATS_BOX_HEIGHT + 1);
+}
+
+void WaveformRenderer::renderRegion(const QRegion & region)
+{
+    // буфер кадра пересоздается только при изменении размера
+    if (mFrame.size() != mView.size) {
+        mFrame = QImage(mView.size, QImage::Format_ARGB32_Premultiplied);
+    }
+    mFrameComplete = true;
+    mCoarseFallback = false;
+    mCoarseTileCount = 0;
+    QPainter painter(&mFrame);
+    // пустая область - перерисовка всего кадра
+    bool partial = !region.isEmpty();
+    if (partial) {
+        painter.setClipRegion(region);
+    }
+
+    QFont font = mView.font;
+    font.setPointSize(8);
+    painter.setFont(font);
+
+    painter.setBrush(QBrush(Qt::white, Qt::SolidPattern));
+    painter.drawRect(0, 0, mView.size.width(), mView.size.height());
+
+    if (mpEDFHeader == nullptr || mpChannels == nullptr || mpEDFHeader->edfsignals <= 0) {
+        // ничего не делаем
+        return;
+    }
+
+    painter.setPen(Qt::black);
+
+    qint32 screenHeight = mView.size.height();
+    qint32 screenWidth = mView.size.width();
+    qint32 channelCount = qint32(mpEDFHeader->edfsignals);
+    qint32 channelHeight = getChannelHeight(channelCount, screenHeight, mView.minChannelHeight);
+    // выводятся, рассчитываются и кэшируются только видимые каналы
+    qint32 firstChannel = qBound(0, mView.firstChannel, channelCount - 1);
+    qint32 lastChannel = firstChannel + getVisibleChannelCount(channelCount, screenHeight, mView.minChannelHeight, firstChannel) - 1;
+    mFrameFirstChannel = mView.firstChannel;
+
+    if (channelHeight != mTileChannelHeight) {
+        invalidateTiles();
+        mTileChannelHeight = channelHeight;
+    }
+    if (mAxisLabels.size() != mpEDFHeader->edfsignals) {
+        mAxisLabels.resize(mpEDFHeader->edfsignals);
+    }
+
+    // статистика точности оценки давления по видимой области
+    PressureStats::Summary pressure;
+
+    // левый край области просмотра в абсолютных пикселях (от начала записи)
+    qint64 startPixel = getStartPixel();
+    mFrameStartPixel = startPixel;
+    qint64 firstTile = startPixel / TILE_WIDTH;
+    qint64 lastTile = (startPixel + screenWidth - 1) / TILE_WIDTH;
+    // при прокрутке в кэше нет только плиток открывшихся столбцов
+    if (mView.frameBudgetMs > 0) {
+        // плитки готовятся по столбцам, пока не исчерпан бюджет кадра; остальные
+        // выводятся в грубом приближении и уточняются в следующих кадрах
+        QElapsedTimer budgetTimer;
+        budgetTimer.start();
+        for (qint64 tileIndex = firstTile; tileIndex <= lastTile; tileIndex++) {
+            if (budgetTimer.elapsed() >= mView.frameBudgetMs) {
+                mCoarseFallback = true;
+                break;
+            }
+            prepareTiles(tileIndex, tileIndex, firstChannel, lastChannel, channelHeight);
+        }
+    } else {
+        prepareTiles(firstTile, lastTile, firstChannel, lastChannel, channelHeight);
+    }
+
+    for (qint32 channel = firstChannel; channel <= lastChannel; channel++)
+    {
+        if (channel < mpChannels->size() && mpChannels->at(channel).samplesCount() > 0)
+        {
+            qint32 channelY = channelHeight * (channel - firstChannel);
+            // готовые плитки канала из кэша (недостающие отрисовываются)
+            for (qint64 tileIndex = firstTile; tileIndex <= lastTile; tileIndex++) {
+                QRect tileRect(int(tileIndex * TILE_WIDTH - startPixel), channelY, TILE_WIDTH, channelHeight);
+                if (partial && !region.intersects(tileRect)) {
+                    continue;
+                }
+                const QImage * pTile = getTile(channel, tileIndex, channelHeight);
+                if (pTile != nullptr) {
+                    painter.drawImage(tileRect.topLeft(), *pTile);
+                }
+            }
+            if (channel == lastChannel) {
+                renderTimeLabels(painter, startPixel, channelY + channelHeight);
+            }
+            if (mAxisLabels[channel].isNull()) {
+                mAxisLabels[channel] = renderAxisLabels(channel, channelHeight);
+            }
+            painter.drawImage(0, channelY, mAxisLabels[channel]);
+        }
+    }
+
+    // статистика собирается по всем каналам независимо от прокрутки по вертикали
+    for (qint32 channel = 0; channel < channelCount && channel < mpChannels->size(); channel++) {
+        const ChannelParams & params = mpChannels->at(channel);
+        double samplesPerPixel = getSamplesPerPixel(channel);
+        qint64 samplesCountAll = params.samplesCount();
+        qint64 startSampleIndex = qint64(double(startPixel) * samplesPerPixel);
+        qint64 endSampleIndex = qMin(samplesCountAll, qint64(double(startPixel + screenWidth) * samplesPerPixel));
+
+        pressure.add(params.pressureStats.getSummary(startSampleIndex, endSampleIndex));
+    }
+
+    if (!mView.showStats) {
+        return;
+    }
+
+    font.setPointSize(14);
+    painter.setFont(font);
+
+    painter.setPen(Qt::lightGray);
+    painter.setBrush(QBrush(QColor(220,220,220,128), Qt::SolidPattern));
+    painter.drawRect(screenWidth - STATS_BOX_WIDTH, 0, screenWidth, STATS_BOX_HEIGHT);
+    painter.setPen(Qt::black);
+
+    QString lo = QString::asprintf("Lo = %.2lf * t + %.2lf\n", mView.aLo, mView.bLo);
+    QString hi = QString::asprintf("Hi = %.2lf * t + %.2lf\n", mView.aHi, mView.bHi);
+    QString n = QString::asprintf("N = %d\n", mView.n);
+
+    painter.drawText(screenWidth - 250 + 10, 25, lo);
+    painter.drawText(screenWidth - 250 + 10, 45, hi);
+    painter.drawText(screenWidth - 250 + 10, 65, n);
+
+    // ошибка каждого давления считается относительно среднего измеренного того же давления
+    if (pressure.loCount > 0)
+    {
+        double pressureLoCalc = pressure.loCalculated / double(pressure.loCount);
+        QString textLo = QString::asprintf("Mean Lo = %.1lf, e=%.1lf%%", pressureLoCalc, pressure.getLoError());
+        painter.drawText(screenWidth - 250 + 10, 85, textLo);
+    }
+
+    if (pressure.hiCount > 0)
+    {
+        double pressureHiCalc = pressure.hiCalculated / double(pressure.hiCount);
+        QString textHi = QString::asprintf("Mean Hi = %.1lf, e=%.1lf%%", pressureHiCalc, pressure.getHiError());
+        painter.drawText(screenWidth - 250 + 10, 105, textHi);
+    }
+}
+
+void WaveformRenderer::renderTimeLabels(QPainter & painter, qint64 startPixel, qint32 bottomY)
+{
+    QPen pen;
+    pen.setStyle(Qt::DotLine);
+    pen.setColor(Qt::gray);
+    QFont font = painter.font();
+    QFont labelFont = font;
+    labelFont.setPointSize(7);
+    painter.setFont(labelFont);
+    painter.setPen(pen);
+
+    // подписи начинаются левее кадра, чтобы попасть в него частично
+    TimeAxisMapper timeAxis = getTimeAxisMapper();
+    timeAxis.getTicks(qMax(qint64(1), startPixel - TILE_LABEL_MARGIN), startPixel + mView.size.width(), mTicks);
+    for (int i = 0; i < mTicks.size(); i++) {
+        qint32 x = qint32(mTicks[i].pixel - startPixel);
+        painter.drawText(x, bottomY - 5, TimeAxisMapper::formatTime(mTicks[i].timeOfDayMs, 1));
+    }
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+}
+
+void WaveformRenderer::invalidateTiles()
+{
+    mFrameValid = false;
+    mTileCache.clear();
+    for (int i = 0; i < mAxisLabels.size(); i++) {
+        mAxisLabels[i] = QImage();
+    }
+}
+
+const QImage * WaveformRenderer::getTile(qint32 channel, qint64 tileIndex, qint32 channelHeight)
+{
+    if (tileIndex < 0) {
+        return nullptr;
+    }
+    quint64 key = getTileKey(channel, tileIndex);
+    QImage * pTile = mTileCache.object(key);
+    if (pTile == nullptr) {
+        // плитка не была подготовлена заранее (вытеснена из кэша или не уложилась в бюджет кадра),
+        // отрисовка на месте
+        TileGeometry & geometry = mFallbackGeometry;
+        geometry.channel = channel;
+        geometry.tileIndex = tileIndex;
+        geometry.channelHeight = channelHeight;
+        geometry.coarse = mCoarseFallback;
+        computeTileGeometry(geometry);
+        if (geometry.coarse) {
+            mCoarseTile = paintTile(geometry);
+            mFrameComplete = false;
+            mCoarseTileCount++;
+            return &mCoarseTile;
+        }
+        pTile = insertTile(geometry);
+    }
+    return pTile;
+}
+
+quint64 WaveformRenderer::getTileKey(qint32 channel, qint64 tileIndex)
+{
+    return (quint64(channel) << 48) | quint64(tileIndex);
+}
+
+QImage * WaveformRenderer::insertTile(const TileGeometry & geometry)
+{
+    QImage * pTile = new QImage(paintTile(geometry));
+    // стоимость плитки в килобайтах
+    int cost = int(qint64(pTile->bytesPerLine()) * pTile->height() / 1024);
+    if (!mTileCache.insert(getTileKey(geometry.channel, geometry.tileIndex), pTile, cost)) {
+        return nullptr;
+    }
+    return pTile;
+}
+
+void WaveformRenderer::prepareTiles(qint64 firstTile, qint64 lastTile, qint32 firstChannel, qint32 lastChannel, qint32 channelHeight)
+{
+    // недостающие плитки группируются по каналам
+    mTileJobs.resize(0);
+    qint32 slotCount = 0;
+    for (qint32 channel = firstChannel; channel <= lastChannel; channel++) {
+        if (channel >= mpChannels->size() || mpChannels->at(channel).samplesCount() == 0) {
+            continue;
+        }
+        ChannelTiles job;
+        job.firstSlot = slotCount;
+        job.slotCount = 0;
+        for (qint64 tileIndex = qMax(qint64(0), firstTile); tileIndex <= lastTile; tileIndex++) {
+            if (mTileCache.contains(getTileKey(channel, tileIndex))) {
+                continue;
+            }
+            if (mTileGeometry.size() <= slotCount) {
+                mTileGeometry.resize(slotCount + 1);
+            }
+            TileGeometry & geometry = mTileGeometry[slotCount];
+            geometry.channel = channel;
+            geometry.tileIndex = tileIndex;
+            geometry.channelHeight = channelHeight;
+            slotCount++;
+            job.slotCount++;
+        }
+        if (job.slotCount > 0) {
+            mTileJobs.append(job);
+        }
+    }
+    if (slotCount == 0) {
+        return;
+    }
+
+    // геометрия каналов вычисляется параллельно (данные только читаются),
+    // отрисовка через QPainter выполняется в вызывающем потоке
+    computeTileGeometry(mTileJobs);
+
+    for (qint32 slot = 0; slot < slotCount; slot++) {
+        insertTile(mTileGeometry[slot]);
+    }
+}
+
+void WaveformRenderer::computeTileGeometry(QVector<ChannelTiles> & jobs)
+{
+    TileGeometry * pGeometry = mTileGeometry.data();
+    auto computeJob = [this, pGeometry](const ChannelTiles & job) {
+        for (qint32 slot = job.firstSlot; slot < job.firstSlot + job.slotCount; slot++) {
+            computeTileGeometry(pGeometry[slot]);
+        }
+    };
+    // один канал считается на месте, без заданий пула (blockingMap выделяет память на каждый вызов)
+    if (jobs.size() == 1 || QThreadPool::globalInstance()->maxThreadCount() <= 1) {
+        for (const ChannelTiles & job : jobs) {
+            computeJob(job);
+        }
+        return;
+    }
+    QtConcurrent::blockingMap(jobs, computeJob);
+}
+
+void WaveformRenderer::computeTileGeometry(TileGeometry & geometry)
+{
+    geometry.polylineCount = 0;
+    geometry.markerCount = 0;
+    geometry.markerBandCount = 0;
+    geometry.labelCount = 0;
+
+    const ChannelParams & params = mpChannels->at(geometry.channel);
+    qint32 channelHeight = geometry.channelHeight;
+
+    // абсолютная координата левого края плитки
+    qint64 tileX = geometry.tileIndex * TILE_WIDTH;
+    qint32 startY = channelHeight / 2;
+    double samplesPerPixel = getSamplesPerPixel(geometry.channel);
+    qreal scale = getValueScale(geometry.channel);
+    qreal meanValue = (params.maxValue + params.minValue) * 0.5;
+    qint64 samplesCountAll = params.samplesCount();
+    const double * pData = params.getSamples();
+
+    if (samplesCountAll == 0) {
+        return;
+    }
+
+    // экранная координата Y для значения отсчета
+    MinMaxPyramid::YMapping mapping;
+    mapping.meanValue = meanValue;
+    mapping.scale = scale;
+    mapping.startY = startY;
+    mapping.height = channelHeight;
+    auto valueToY = [&](double value) {
+        return mapping.toY(value);
+    };
+    // координата X отсчета относительно плитки
+    auto sampleToX = [&](qint64 sampleIndex) {
+        return qint32(qint64(double(sampleIndex) / samplesPerPixel) - tileX);
+    };
+
+    if (samplesPerPixel > 1.0) {
+        // прореживание по пирамиде минимумов/максимумов: для каждого столбца
+        // берется сводка с уровня, ближайшего к количеству отсчетов на пиксель;
+        // по столбцу с каждой стороны за пределами плитки для стыковки с соседними плитками
+        // в грубом приближении столбец сводки шириной columnStep пикселей
+        const MinMaxPyramid & pyramid = params.pyramid;
+        qint32 columnStep = geometry.coarse ? COARSE_COLUMN_STEP : 1;
+        int level = pyramid.findLevel(samplesPerPixel * columnStep);
+        // на уровне -1 (меньше LEVEL_FACTOR отсчетов на столбец) столбцы строятся ядром по исходным отсчетам
+        qint64 firstX = qMax(qint64(0), tileX - columnStep);
+        qint32 columnCount = qint32((tileX + TILE_WIDTH - firstX) / columnStep) + 1;
+        if (geometry.columns.size() < columnCount) {
+            geometry.columns.resize(columnCount);
+        }
+        MinMaxPyramid::Column * columns = geometry.columns.data();
+        if (level < 0) {
+            columnCount = MinMaxPyramid::buildColumns(pData, samplesCountAll, samplesPerPixel, firstX, columnStep,
+                                                      columnCount, mapping, columns);
+        } else {
+            for (qint32 column = 0; column < columnCount; column++) {
+                qint64 absX = firstX + qint64(column) * columnStep;
+                qint64 beginSample = qint64(double(absX) * samplesPerPixel);
+                qint64 endSample = qint64(double(absX + columnStep) * samplesPerPixel);
+                if (beginSample >= samplesCountAll) {
+                    columnCount = column;
+                    break;
+                }
+                if (endSample > samplesCountAll) endSample = samplesCountAll;
+                columns[column] = MinMaxPyramid::getColumn(pyramid.getRange(level, beginSample, endSample, pData), mapping);
+            }
+        }
+
+        if (geometry.polyline.size() < (TILE_WIDTH + 2) * 2) {
+            geometry.polyline.resize((TILE_WIDTH + 2) * 2);
+        }
+        QPoint * points = geometry.polyline.data();
+        qint32 pointCount = 0;
+        for (qint32 column = 0; column < columnCount; column++) {
+            qint32 x = qint32(firstX + qint64(column) * columnStep - tileX);
+            qint32 yTop = columns[column].yTop;
+            qint32 yBottom = columns[column].yBottom;
+            if (yTop == yBottom) {
+                points[pointCount++] = QPoint(x, yTop);
+            } else if (columns[column].falling) {
+                // спад внутри столбца: сначала максимум, затем минимум
+                points[pointCount++] = QPoint(x, yTop);
+                points[pointCount++] = QPoint(x, yBottom);
+            } else {
+                points[pointCount++] = QPoint(x, yBottom);
+                points[pointCount++] = QPoint(x, yTop);
+            }
+        }
+        geometry.polylineCount = pointCount;
+    } else {
+        // отсчетов не больше, чем столбцов: ломаная строится по отсчетам и в грубом приближении
+        // по отсчету с каждой стороны за пределами плитки
+        qint64 beginSample = qMax(qint64(0), qint64(double(tileX) * samplesPerPixel) - 1);
+        qint64 endSample = qMin(samplesCountAll, qint64(double(tileX + TILE_WIDTH) * samplesPerPixel) + 2);
+        if (beginSample < endSample) {
+            if (geometry.polyline.size() < endSample - beginSample) {
+                geometry.polyline.resize(int(endSample - beginSample));
+            }
+            QPoint * points = geometry.polyline.data();
+            for (qint64 sampleIndex = beginSample; sampleIndex < endSample; sampleIndex++)
+            {
+                points[sampleIndex - beginSample].setX(sampleToX(sampleIndex));
+                points[sampleIndex - beginSample].setY(valueToY(pData[sampleIndex]));
+            }
+            geometry.polylineCount = qint32(endSample - beginSample);
+        }
+    }
+
+    if (geometry.coarse) {
+        return;
+    }
+
+    // маркеры пиков и давлений: обходятся только отсчеты с событиями
+    const std::vector<qint64> & events = params.events;
+    qint64 firstEventSample = qMax(qint64(0), qint64(double(tileX - 4) * samplesPerPixel));
+    auto firstEventIt = std::lower_bound(events.begin(), events.end(), firstEventSample);
+
+    // если маркеры не помещаются по ширине, вместо них и подписей выводятся сводки по полосам:
+    // стоимость плитки ограничена количеством полос, а не количеством событий
+    qint64 tileEndSample = qint64(double(tileX + TILE_WIDTH) * samplesPerPixel);
+    qint64 tileEventCount = qint64(std::lower_bound(firstEventIt, events.end(), tileEndSample) - firstEventIt);
+    if (tileEventCount > TILE_WIDTH / MARKER_MIN_SPACING &&
+            params.eventRateCounts.size() == events.size() + 1) {
+        qint32 bandCount = TILE_WIDTH / MARKER_BAND_WIDTH;
+        if (geometry.markerBands.size() < bandCount) {
+            geometry.markerBands.resize(bandCount);
+        }
+        auto bandBeginIt = std::lower_bound(events.begin(), events.end(), qint64(double(tileX) * samplesPerPixel));
+        for (qint32 band = 0; band < bandCount; band++) {
+            qint64 bandEndSample = qint64(double(tileX + (band + 1) * MARKER_BAND_WIDTH) * samplesPerPixel);
+            auto bandEndIt = std::lower_bound(bandBeginIt, events.end(), bandEndSample);
+            size_t beginIndex = size_t(bandBeginIt - events.begin());
+            size_t endIndex = size_t(bandEndIt - events.begin());
+            bandBeginIt = bandEndIt;
+            if (beginIndex == endIndex) {
+                continue;
+            }
+            MarkerBand & markerBand = geometry.markerBands[geometry.markerBandCount++];
+            markerBand.x = band * MARKER_BAND_WIDTH;
+            markerBand.count = qint64(endIndex - beginIndex);
+            qint64 rateCount = params.eventRateCounts[endIndex] - params.eventRateCounts[beginIndex];
+            markerBand.meanRate = rateCount > 0 ?
+                        (params.eventRateSums[endIndex] - params.eventRateSums[beginIndex]) / double(rateCount) : 0.0;
+        }
+        return;
+    }
+
+    for (auto eventIt = firstEventIt; eventIt != events.end(); ++eventIt)
+    {
+        qint32 x = sampleToX(*eventIt);
+        if (x < -3) continue;
+        if (x > TILE_WIDTH + 1) break;
+        if (geometry.markers.size() <= geometry.markerCount) {
+            geometry.markers.resize(qMax(64, geometry.markers.size() * 2));
+        }
+        geometry.markers[geometry.markerCount++] = QPoint(x, valueToY(pData[*eventIt]));
+    }
+
+    // подписи событий, включая начинающиеся левее плитки и заходящие в нее
+    const std::vector<EventLabel> & labels = params.labels;
+    qint64 firstLabelSample = qMax(qint64(0), qint64(double(tileX - TILE_LABEL_MARGIN) * samplesPerPixel));
+    auto labelIt = std::lower_bound(labels.begin(), labels.end(), firstLabelSample,
+                                    [](const EventLabel & label, qint64 sampleIndex) { return label.sampleIndex < sampleIndex; });
+    for (; labelIt != labels.end(); ++labelIt)
+    {
+        qint32 x = sampleToX(labelIt->sampleIndex);
+        if (x < -TILE_LABEL_MARGIN) continue;
+        if (x > TILE_WIDTH) break;
+        if (geometry.labelPoints.size() <= geometry.labelCount) {
+            geometry.labelPoints.resize(qMax(64, geometry.labelPoints.size() * 2));
+            geometry.labelIndexes.resize(geometry.labelPoints.size());
+        }
+        geometry.labelPoints[geometry.labelCount] = QPoint(x, valueToY(pData[labelIt->sampleIndex]));
+        geometry.labelIndexes[geometry.labelCount] = qint64(labelIt - labels.begin());
+        geometry.labelCount++;
+    }
+}
+
+QImage WaveformRenderer::paintTile(const TileGeometry & geometry)
+{
+    qint32 channel = geometry.channel;
+    qint32 channelHeight = geometry.channelHeight;
+    QImage image(TILE_WIDTH, channelHeight, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    const ChannelParams & params = mpChannels->at(channel);
+
+    QPainter painter(&image);
+    QFont tileFont = mView.font;
+    tileFont.setPointSize(8);
+    painter.setFont(tileFont);
+
+    // абсолютная координата левого края плитки
+    qint64 tileX = geometry.tileIndex * TILE_WIDTH;
+    double samplesPerPixel = getSamplesPerPixel(channel);
+
+    {
+        // time rulers (по каналу 0); подписи выводятся поверх плиток в renderTimeLabels,
+        // поэтому плитка не зависит от того, какой канал последний на экране
+        QPen pen;
+        pen.setStyle(Qt::DotLine);
+        pen.setColor(Qt::gray);
+        painter.setPen(pen);
+
+        TimeAxisMapper timeAxis = getTimeAxisMapper();
+        timeAxis.getTicks(qMax(qint64(1), tileX), tileX + TILE_WIDTH, mTicks);
+        for (int i = 0; i < mTicks.size(); i++) {
+            qint32 x = qint32(mTicks[i].pixel - tileX);
+            painter.drawLine(x, 0, x, channelHeight);
+        }
+        painter.setPen(Qt::SolidLine);
+    }
+
+    if (params.samplesCount() == 0) {
+        return image;
+    }
+
+    if (isGridChannel(channel))
+    {
+        QPen pen;
+        pen.setStyle(Qt::DotLine);
+        pen.setColor(Qt::gray);
+        painter.setPen(pen);
+        int minRowHeight = 20;
+        for (int row = 0; row <= channelHeight / minRowHeight; row++) {
+            int y = row * minRowHeight;
+            painter.drawLine(0, y, TILE_WIDTH, y);
+            if (y + 10 > channelHeight) break;
+        }
+        pen.setStyle(Qt::SolidLine);
+        painter.setPen(pen);
+        painter.drawLine(0, channelHeight - 1, TILE_WIDTH, channelHeight - 1);
+    }
+
+    painter.setBrush(QBrush(Qt::red, Qt::SolidPattern));
+    if (channel == mView.channelECG) {
+        painter.setPen(Qt::darkRed);
+    } else if (channel == mView.channelPlethism) {
+        painter.setPen(Qt::darkGreen);
+    } else {
+        painter.setPen(Qt::black);
+    }
+
+    painter.drawPolyline(geometry.polyline.constData(), geometry.polylineCount);
+
+    for (qint32 i = 0; i < geometry.markerCount; i++) {
+        const QPoint & point = geometry.markers[i];
+        painter.drawEllipse(point.x()-1, point.y()-1, 4, 4);
+    }
+
+    // сводки событий: насыщенность полосы по плотности событий (насыщение при одном событии на пиксель),
+    // подпись - количество событий и средняя ЧСС
+    if (geometry.markerBandCount > 0) {
+        QFont bandFont = tileFont;
+        bandFont.setPointSize(7);
+        painter.setFont(bandFont);
+        painter.setPen(Qt::NoPen);
+        for (qint32 i = 0; i < geometry.markerBandCount; i++) {
+            const MarkerBand & band = geometry.markerBands[i];
+            int alpha = qMin(255, 32 + int(223.0 * double(band.count) / double(MARKER_BAND_WIDTH)));
+            painter.setBrush(QBrush(QColor(255, 0, 0, alpha), Qt::SolidPattern));
+            painter.drawRect(band.x, 0, MARKER_BAND_WIDTH - 1, MARKER_BAND_HEIGHT);
+        }
+        painter.setPen(Qt::black);
+        for (qint32 i = 0; i < geometry.markerBandCount; i++) {
+            const MarkerBand & band = geometry.markerBands[i];
+            QString text = band.meanRate > 0 ? QString::asprintf("%lld / %.0lf", band.count, band.meanRate) :
+                                               QString::asprintf("%lld", band.count);
+            painter.drawText(QRect(band.x + 2, 0, MARKER_BAND_WIDTH - 4, MARKER_BAND_HEIGHT), Qt::AlignLeft | Qt::AlignVCenter, text);
+        }
+        painter.setFont(tileFont);
+    }
+
+    // подпись выводится, только если следующая подпись той же строки начинается после ее конца
+    const std::vector<EventLabel> & labels = params.labels;
+    qint32 ascent = QFontMetrics(tileFont).ascent();
+    for (qint32 i = 0; i < geometry.labelCount; i++) {
+        const EventLabel & label = labels[geometry.labelIndexes[i]];
+        QStaticText layout = getLabelLayout(label.text, tileFont);
+        if (label.nextInRow >= 0) {
+            double gap = double(labels[label.nextInRow].sampleIndex - label.sampleIndex) / samplesPerPixel;
+            if (gap < layout.size().width() + LABEL_SPACING) continue;
+        }
+        const QPoint & point = geometry.labelPoints[i];
+        painter.drawStaticText(point.x(), point.y() + label.offsetY - ascent, layout);
+    }
+    return image;
+}
+
+QImage WaveformRenderer::renderAxisLabels(qint32 channel, qint32 channelHeight)
+{
+    QImage image(AXIS_LABEL_WIDTH, channelHeight, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    if (!isGridChannel(channel)) {
+        return image;
+    }
+
+    QPainter painter(&image);
+    QFont labelFont = mView.font;
+    labelFont.setPointSize(7);
+    painter.setFont(labelFont);
+    QPen pen;
+    pen.setColor(Qt::gray);
+    painter.setPen(pen);
+
+    qint32 startY = channelHeight / 2;
+    qreal scale = getValueScale(channel);
+    qreal meanValue = (mpChannels->at(channel).maxValue + mpChannels->at(channel).minValue) * 0.5;
+    int minRowHeight = 20;
+    for (int row = 0; row <= channelHeight / minRowHeight; row++) {
+        int y = row * minRowHeight;
+        if (y + 10 > channelHeight) break;
+        double value = meanValue - double(y - startY) / scale;
+        painter.drawText(5, y+10,  QString::asprintf("%lf", value));
+    }
+    return image;
+}
+
+bool WaveformRenderer::isGridChannel(int channel)
+{
+    return QString(mpEDFHeader->signalparam[channel].physdimension).contains("V") &&
+            !QString(mpEDFHeader->signalparam[channel].label).contains("PLET", Qt::CaseInsensitive) &&
+            !QString(mpEDFHeader->signalparam[channel].label).contains("RESP", Qt::CaseInsensitive);
+}
+
+qreal WaveformRenderer::getValueScale(int channel)
+{
+    return MAGIC_POWER_SCALER * qreal(mpEDFHeader->signalparam[channel].dig_max - mpEDFHeader->signalparam[channel].dig_min) /
+            ((mpEDFHeader->signalparam[channel].phys_max - mpEDFHeader->signalparam[channel].phys_min) * mView.scalingFactors.at(channel));
+}
+
+TimeAxisMapper WaveformRenderer::getTimeAxisMapper()
+{
+    // линейка времени строится по каналу 0
+    TimeAxisMapper timeAxis;
+    timeAxis.setup(getStartOfDayMs(mpEDFHeader), 1000.0 * getSamplesPerPixel(0) / getSampleRate(mpEDFHeader, 0), 50);
+    return timeAxis;
+}
+
+double WaveformRenderer::getSamplesPerPixel(int channel)
+{
+    return getSamplesPerPixel(mpEDFHeader, channel, mView.sweepFactor);
+}
+
+double WaveformRenderer::getSampleRate(const edf_hdr_struct * pEDFHeader, int channel)
+{
+    return ((double)pEDFHeader->signalparam[channel].smp_in_datarecord /
+            (double)pEDFHeader->datarecord_duration) * EDFLIB_TIME_DIMENSION;
+}
+
+double WaveformRenderer::getSamplesPerPixel(const edf_hdr_struct * pEDFHeader, int channel, qreal sweepFactor)
+{
+    return getSampleRate(pEDFHeader, channel) * MAGIC_TIME_SCALER / sweepFactor;
+}
+
+qint64 WaveformRenderer::getStartPixel()
+{
+    if (mView.startPixel >= 0) {
+        return mView.startPixel;
+    }
+    return getScrollPixel(mpEDFHeader, mView.scroll, mView.sweepFactor);
+}
+
+double WaveformRenderer::getPixelsPerSecond(qreal sweepFactor)
+{
+    return sweepFactor / MAGIC_TIME_SCALER;
+}
+
+qint64 WaveformRenderer::getScrollPixel(const edf_hdr_struct * pEDFHeader, qreal scroll, qreal sweepFactor)
+{
+    qint64 referenceStartIndex = qint64(scroll * qreal(pEDFHeader->signalparam[0].smp_in_file));
+    return qint64(double(referenceStartIndex) / getSamplesPerPixel(pEDFHeader, 0, sweepFactor));
+}
+
+double WaveformRenderer::getStartOfDayMs(const edf_hdr_struct * pEDFHeader)
+{
+    QTime startTime(pEDFHeader->starttime_hour, pEDFHeader->starttime_minute, pEDFHeader->starttime_second);
+    return double(startTime.msecsSinceStartOfDay()) + double(pEDFHeader->starttime_subsecond) / 10000.0;
+}
+
+qint32 WaveformRenderer::getChannelHeight(qint32 channelCount, qint32 frameHeight, qint32 minChannelHeight)
+{
+    if (channelCount <= 0) {
+        return frameHeight;
+    }
+    return qMax(frameHeight / channelCount, minChannelHeight);
+}
+
+qint32 WaveformRenderer::getVisibleChannelCount(qint32 channelCount, qint32 frameHeight, qint32 minChannelHeight, qint32 firstChannel)
+{
+    qint32 channelHeight = getChannelHeight(channelCount, frameHeight, minChannelHeight);
+    if (channelCount <= 0 || channelHeight <= 0) {
+        return 0;
+    }
+    // нижний канал может быть виден частично
+    qint32 visibleCount = (frameHeight + channelHeight - 1) / channelHeight;
+    return qBound(0, qMin(visibleCount, channelCount - firstChannel), channelCount);
+}
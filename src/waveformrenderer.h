@@ -0,0 +1,249 @@
+#ifndef WAVEFORMRENDERER_H
+#define WAVEFORMRENDERER_H
+
+#include <QCache>
+#include <QFont>
+#include <QImage>
+#include <QRegion>
+#include <QStaticText>
+#include <QVector>
+#include "EDFlib/edflib.h"
+#include "channelparams.h"
+#include "timeaxismapper.h"
+
+class QPainter;
+
+// параметры вида для отрисовки кадра
+// неизменяемый снимок, передается в поток отрисовки вместе с запросом кадра
+struct ViewParams {
+    // номер запроса кадра
+    quint64 generation;
+    // версия данных и результатов расчета (при изменении кэш плиток сбрасывается)
+    quint64 contentGeneration;
+    //
+    QSize size;
+    //
+    QFont font;
+    // разрешение по времени
+    qreal sweepFactor;
+    // прокрутка по времени (0..1)
+    qreal scroll;
+    // левый край кадра в пикселях от начала записи (-1 - по прокрутке scroll)
+    qint64 startPixel;
+    // первый выводимый канал (прокрутка по вертикали)
+    qint32 firstChannel;
+    // минимальная высота полосы канала, пикс (0 - каналы делят высоту кадра поровну)
+    qint32 minChannelHeight;
+    // масштабирующие коэффициенты каналов
+    QVector<qreal> scalingFactors;
+    // индекс канала кардиограммы
+    int channelECG;
+    // индекс канала плетизмограммы
+    int channelPlethism;
+    // коэффициенты калибровки для блока статистики
+    double aHi;
+    double aLo;
+    double bHi;
+    double bLo;
+    int n;
+    // вывод блока статистики
+    bool showStats;
+    // бюджет времени на подготовку плиток кадра, мс (0 - кадр всегда отрисовывается полностью);
+    // не уложившиеся в бюджет плитки выводятся в грубом приближении и уточняются в следующих кадрах
+    int frameBudgetMs;
+
+    ViewParams() {
+        generation = 0;
+        contentGeneration = 0;
+        sweepFactor = 30.0;
+        scroll = 0.0;
+        startPixel = -1;
+        firstChannel = 0;
+        minChannelHeight = 0;
+        channelECG = 1;
+        channelPlethism = 0;
+        aHi = 0;
+        aLo = 0;
+        bHi = 0;
+        bLo = 0;
+        n = 0;
+        showStats = true;
+        frameBudgetMs = 0;
+    }
+};
+
+// сводка событий полосы шириной MARKER_BAND_WIDTH при плотном расположении маркеров
+struct MarkerBand {
+    // левый край полосы относительно плитки
+    qint32 x;
+    // количество событий
+    qint64 count;
+    // средняя ЧСС по событиям полосы (0, если ЧСС не измерена)
+    double meanRate;
+};
+
+// геометрия плитки канала в координатах плитки
+struct TileGeometry {
+    //
+    qint32 channel;
+    //
+    qint64 tileIndex;
+    //
+    qint32 channelHeight;
+    // грубое приближение: сигнал по сводкам пирамиды через COARSE_COLUMN_STEP столбцов, без маркеров и подписей
+    bool coarse;
+    // столбцы ломаной по сводкам пирамиды или по исходным отсчетам
+    QVector<MinMaxPyramid::Column> columns;
+    // вершины ломаной сигнала
+    QVector<QPoint> polyline;
+    qint32 polylineCount;
+    // центры маркеров событий
+    QVector<QPoint> markers;
+    qint32 markerCount;
+    // сводки событий по полосам (вместо маркеров и подписей, если событий больше, чем помещается по ширине)
+    QVector<MarkerBand> markerBands;
+    qint32 markerBandCount;
+    // точки привязки подписей-кандидатов и индексы подписей канала
+    QVector<QPoint> labelPoints;
+    QVector<qint64> labelIndexes;
+    qint32 labelCount;
+
+    TileGeometry() {
+        channel = 0;
+        tileIndex = 0;
+        channelHeight = 0;
+        coarse = false;
+        polylineCount = 0;
+        markerCount = 0;
+        markerBandCount = 0;
+        labelCount = 0;
+    }
+};
+
+// группа недостающих плиток одного канала в буфере геометрии
+struct ChannelTiles {
+    qint32 firstSlot;
+    qint32 slotCount;
+};
+
+// отрисовка кадров с сигналами каналов в QImage без привязки к виджету
+// кадр собирается из кэшируемых плиток; хранит предыдущий кадр для сдвига при прокрутке
+// не потокобезопасен: один экземпляр используется одним потоком, данные каналов
+// на время вызова renderFrame не должны изменяться
+class WaveformRenderer
+{
+    // замер подготовки геометрии плиток (bench/tilegeometry)
+    friend class TileGeometryBench;
+
+public:
+    WaveformRenderer();
+
+    // заголовок файла и данные каналов
+    void setData(const edf_hdr_struct * pEDFHeader, const QVector<ChannelParams> * pChannels);
+    // кадр для параметров вида
+    QImage renderFrame(const ViewParams & view);
+    // объем кэша плиток, Кб
+    void setTileCacheSize(int kilobytes);
+    // все ли плитки последнего кадра отрисованы полностью (иначе кадр нужно уточнить повторным вызовом renderFrame)
+    bool isFrameComplete() const;
+
+    //
+    static double getSampleRate(const edf_hdr_struct * pEDFHeader, int channel);
+    // количество отсчетов канала на пиксель при развертке sweepFactor
+    static double getSamplesPerPixel(const edf_hdr_struct * pEDFHeader, int channel, qreal sweepFactor);
+    // пикселей на секунду записи при развертке sweepFactor
+    static double getPixelsPerSecond(qreal sweepFactor);
+    // левый край области просмотра в пикселях от начала записи
+    static qint64 getScrollPixel(const edf_hdr_struct * pEDFHeader, qreal scroll, qreal sweepFactor);
+    // время начала записи от начала суток, мс
+    static double getStartOfDayMs(const edf_hdr_struct * pEDFHeader);
+    // высота полосы канала: высота кадра делится поровну, но не меньше minChannelHeight
+    static qint32 getChannelHeight(qint32 channelCount, qint32 frameHeight, qint32 minChannelHeight);
+    // количество полностью или частично видимых каналов, начиная с firstChannel
+    static qint32 getVisibleChannelCount(qint32 channelCount, qint32 frameHeight, qint32 minChannelHeight, qint32 firstChannel);
+
+private:
+    // заголовок файла EDF (nullptr, если данных нет)
+    const edf_hdr_struct * mpEDFHeader;
+    // параметры и данные каналов
+    const QVector<ChannelParams> * mpChannels;
+    // параметры вида текущего кадра
+    ViewParams mView;
+
+    // кэш разметки подписей (по тексту)
+    QCache<QString, QStaticText> mLabelLayouts;
+    // готовая разметка подписи
+    QStaticText getLabelLayout(const QString & text, const QFont & font);
+
+    // кэш отрисованных плиток каналов (ключ: канал и номер плитки по времени)
+    QCache<quint64, QImage> mTileCache;
+    // подписи значений сетки каналов (выводятся поверх плиток у левого края)
+    QVector<QImage> mAxisLabels;
+    // высота полосы канала, для которой построен кэш
+    qint32 mTileChannelHeight;
+    // сброс кэша при изменении данных, масштаба, развертки или результатов расчета
+    void invalidateTiles();
+    // изменились ли параметры, от которых зависит содержимое плиток
+    bool isTileContentChanged(const ViewParams & view) const;
+    // плитка из кэша (при отсутствии отрисовывается)
+    const QImage * getTile(qint32 channel, qint64 tileIndex, qint32 channelHeight);
+    // ключ плитки в кэше
+    static quint64 getTileKey(qint32 channel, qint64 tileIndex);
+    // отрисовка недостающих плиток видимых каналов: геометрия каналов считается
+    // параллельно в пуле потоков, рисование выполняется в вызывающем потоке
+    void prepareTiles(qint64 firstTile, qint64 lastTile, qint32 firstChannel, qint32 lastChannel, qint32 channelHeight);
+    // вычисление геометрии плитки (без QPainter, допускает вызов из пула потоков)
+    void computeTileGeometry(TileGeometry & geometry);
+    // вычисление геометрии плиток в буфере mTileGeometry по каналам в пуле потоков
+    void computeTileGeometry(QVector<ChannelTiles> & jobs);
+    // отрисовка плитки канала по геометрии: сетка, линии времени, сигнал, маркеры и подписи
+    QImage paintTile(const TileGeometry & geometry);
+    // отрисовка плитки и помещение ее в кэш
+    QImage * insertTile(const TileGeometry & geometry);
+    // постоянные буферы геометрии плиток (только растут, без выделения памяти на каждый кадр)
+    QVector<TileGeometry> mTileGeometry;
+    // группы недостающих плиток по каналам и метки линейки времени (емкость сохраняется между кадрами)
+    QVector<ChannelTiles> mTileJobs;
+    QVector<TimeAxisMapper::Tick> mTicks;
+    // геометрия плитки, вытесненной из кэша до вывода кадра
+    TileGeometry mFallbackGeometry;
+    // бюджет времени кадра исчерпан: недостающие плитки выводятся в грубом приближении
+    bool mCoarseFallback;
+    // грубая плитка (в кэш не помещается)
+    QImage mCoarseTile;
+    // в кадре нет грубых плиток
+    bool mFrameComplete;
+    // количество грубых плиток в кадре
+    qint32 mCoarseTileCount;
+    //
+    QImage renderAxisLabels(qint32 channel, qint32 channelHeight);
+    // канал с сеткой по амплитуде
+    bool isGridChannel(int channel);
+    // количество отсчетов канала на пиксель при текущей развертке
+    double getSamplesPerPixel(int channel);
+    // пикселей на единицу физической величины
+    qreal getValueScale(int channel);
+    // соответствие пикселей и времени для линейки
+    TimeAxisMapper getTimeAxisMapper();
+    // левый край кадра в пикселях от начала записи
+    qint64 getStartPixel();
+
+    // последний кадр
+    QImage mFrame;
+    //
+    bool mFrameValid;
+    // абсолютная координата левого края кадра mFrame
+    qint64 mFrameStartPixel;
+    // первый канал кадра mFrame
+    qint32 mFrameFirstChannel;
+    // отрисовка кадра из плиток, подписей сетки и статистики (region пуст - весь кадр)
+    void renderRegion(const QRegion & region);
+    // подписи линейки времени по нижнему краю bottomY последнего видимого канала (поверх плиток)
+    void renderTimeLabels(QPainter & painter, qint64 startPixel, qint32 bottomY);
+    // сдвиг кадра при горизонтальной прокрутке и отрисовка только открывшихся столбцов
+    void scrollFrame();
+    // блок статистики (перерисовывается при прокрутке)
+    QRect getStatsBoxRect();
+};
+
+#endif // WAVEFORMRENDERER_H
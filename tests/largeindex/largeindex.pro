@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Индексы отсчетов за пределами 2^31 (синтетический файл EDF)
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_largeindex
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += tst_largeindex.cpp \
+        $$SRC/EDFlib/edflib.c \
+        $$SRC/edfreader.cpp \
+        $$SRC/minmaxpyramid.cpp \
+        $$SRC/sampleindexmap.cpp
+
+HEADERS  += $$SRC/EDFlib/edflib.h \
+    $$SRC/edfreader.h \
+    $$SRC/minmaxpyramid.h \
+    $$SRC/sampleindexmap.h
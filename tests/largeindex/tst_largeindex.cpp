@@ -0,0 +1,281 @@
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+#include <limits.h>
+#include <vector>
+#include "EDFlib/edflib.h"
+#include "edfreader.h"
+#include "sampleindexmap.h"
+#include "minmaxpyramid.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+
+// синтетический файл EDF: один канал, 71900 записей по 30000 отсчетов = 2157000000 отсчетов > 2^31
+#define TEST_SAMPLES_IN_RECORD 30000
+#define TEST_DATARECORDS 71900
+// размер заголовка файла с одним каналом, байт
+#define TEST_HEADER_SIZE 512
+// отсчеты с начала этой области до конца файла заполняются тестовой последовательностью, остальные нули
+#define TEST_PATTERN_BEGIN (qint64(INT_MAX) - (4 << 20))
+// отсчетов в пирамиде (на 1M больше 2^31)
+#define TEST_PYRAMID_SAMPLES ((qint64(1) << 31) + (1 << 20))
+
+class TestLargeIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void percentToIndex();
+    void sampleIndexMap();
+    void readBlocksAcrossIntMax();
+    void readTail();
+    void pyramidRangesAcrossIntMax();
+
+private:
+    //
+    QTemporaryDir mDir;
+    // заголовок открытого синтетического файла
+    edf_hdr_struct mEDFHeader;
+    bool mOpened = false;
+
+    //
+    static qint64 getSamplesCount() { return qint64(TEST_DATARECORDS) * TEST_SAMPLES_IN_RECORD; }
+    // цифровое значение отсчета sampleIndex в синтетическом файле (физическое совпадает с цифровым)
+    static qint16 getPatternValue(qint64 sampleIndex) { return qint16(sampleIndex % 65521 - 32768); }
+    static double getExpectedValue(qint64 sampleIndex);
+    // поле заголовка EDF: значение, дополненное пробелами до size символов
+    static QByteArray getField(const QByteArray & value, int size);
+    // запись синтетического файла (до TEST_PATTERN_BEGIN файл расширяется без записи отсчетов)
+    bool writeFile(const QString & fileName);
+};
+
+double TestLargeIndex::getExpectedValue(qint64 sampleIndex)
+{
+    return sampleIndex >= TEST_PATTERN_BEGIN ? getPatternValue(sampleIndex) : 0;
+}
+
+QByteArray TestLargeIndex::getField(const QByteArray & value, int size)
+{
+    return value.leftJustified(size, ' ', true);
+}
+
+bool TestLargeIndex::writeFile(const QString & fileName)
+{
+    // заголовок EDF (EDFlib записывает только EDF+ с каналом аннотаций)
+    QByteArray header;
+    header += getField("0", 8);
+    header += getField("X X X X", 80);
+    header += getField("Startdate X X X X", 80);
+    header += getField("01.01.20", 8);
+    header += getField("00.00.00", 8);
+    header += getField(QByteArray::number(TEST_HEADER_SIZE), 8);
+    header += getField("", 44);
+    header += getField(QByteArray::number(TEST_DATARECORDS), 8);
+    header += getField("1", 8);
+    header += getField("1", 4);
+    // канал: физические величины совпадают с цифровыми
+    header += getField("TEST", 16);
+    header += getField("", 80);
+    header += getField("uV", 8);
+    header += getField("-32768", 8);
+    header += getField("32767", 8);
+    header += getField("-32768", 8);
+    header += getField("32767", 8);
+    header += getField("", 80);
+    header += getField(QByteArray::number(TEST_SAMPLES_IN_RECORD), 8);
+    header += getField("", 32);
+
+    QFile file(fileName);
+    if (header.size() != TEST_HEADER_SIZE || !file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(header) != TEST_HEADER_SIZE || !file.resize(TEST_HEADER_SIZE + 2 * getSamplesCount())) {
+        return false;
+    }
+    // тестовая последовательность от TEST_PATTERN_BEGIN до конца, остальные отсчеты не записываются
+    // (в записи один канал, поэтому отсчет sampleIndex лежит по смещению TEST_HEADER_SIZE + 2 * sampleIndex)
+    if (!file.seek(TEST_HEADER_SIZE + 2 * TEST_PATTERN_BEGIN)) {
+        return false;
+    }
+    std::vector<char> block(2 << 20);
+    for (qint64 begin = TEST_PATTERN_BEGIN; begin < getSamplesCount(); ) {
+        qint64 count = qMin(qint64(block.size() / 2), getSamplesCount() - begin);
+        for (qint64 i = 0; i < count; i++) {
+            quint16 value = quint16(getPatternValue(begin + i));
+            block[2 * i] = char(value & 0xff);
+            block[2 * i + 1] = char(value >> 8);
+        }
+        if (file.write(block.data(), 2 * count) != 2 * count) {
+            return false;
+        }
+        begin += count;
+    }
+    return true;
+}
+
+void TestLargeIndex::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+    QString fileName = mDir.filePath("large.edf");
+    QVERIFY2(writeFile(fileName), "can't write the synthetic EDF file");
+    QByteArray path = QFile::encodeName(fileName);
+    QCOMPARE(edfopen_file_readonly(path.constData(), &mEDFHeader, EDFLIB_DO_NOT_READ_ANNOTATIONS), 0);
+    mOpened = true;
+    QCOMPARE(mEDFHeader.edfsignals, 1);
+    QCOMPARE(qint64(mEDFHeader.signalparam[0].smp_in_file), getSamplesCount());
+    QVERIFY(qint64(mEDFHeader.signalparam[0].smp_in_file) > qint64(INT_MAX));
+}
+
+void TestLargeIndex::cleanupTestCase()
+{
+    if (mOpened) {
+        edfclose_file(mEDFHeader.handle);
+    }
+}
+
+void TestLargeIndex::percentToIndex()
+{
+    qint64 samplesCount = getSamplesCount();
+    for (int percent = 0; percent <= 100; percent++) {
+        QCOMPARE(::percentToIndex(percent, samplesCount), percent * (samplesCount / 100));
+    }
+    QVERIFY(::percentToIndex(100, samplesCount) > qint64(INT_MAX));
+    // десятки суток на 1 кГц
+    qint64 longCount = qint64(1) << 42;
+    QCOMPARE(::percentToIndex(50, longCount), longCount / 2);
+    QCOMPARE(::percentToIndex(100, longCount), longCount);
+}
+
+void TestLargeIndex::sampleIndexMap()
+{
+    // пары частот (отсчетов в записи данных) исходного канала и канала назначения
+    const qint64 rates[][2] = { {250, 125}, {125, 250}, {300, 128}, {1, TEST_SAMPLES_IN_RECORD}, {TEST_SAMPLES_IN_RECORD, 7} };
+    const qint64 indices[] = { qint64(INT_MAX) - 1, qint64(INT_MAX), qint64(INT_MAX) + 1, getSamplesCount() - 1,
+                               (qint64(1) << 32) - 1, qint64(1) << 32, (qint64(1) << 32) + 1, qint64(30) * 1000 * 1000 * 1000 };
+    for (const auto & rate : rates) {
+        SampleIndexMap indexMap(rate[0], rate[1]);
+        for (qint64 index : indices) {
+            // map - последний отсчет назначения не позже index, mapCeil - первый не раньше
+            qint64 mapped = indexMap.map(index);
+            QVERIFY(mapped * rate[0] <= index * rate[1]);
+            QVERIFY((mapped + 1) * rate[0] > index * rate[1]);
+            qint64 mappedCeil = indexMap.mapCeil(index);
+            QVERIFY(mappedCeil * rate[0] >= index * rate[1]);
+            QVERIFY((mappedCeil - 1) * rate[0] < index * rate[1]);
+            // unmap - последний исходный отсчет не позже отсчета назначения index
+            qint64 unmapped = indexMap.unmap(index);
+            QVERIFY(unmapped * rate[1] <= index * rate[0]);
+            QVERIFY((unmapped + 1) * rate[1] > index * rate[0]);
+        }
+    }
+    SampleIndexMap half(250, 125);
+    QCOMPARE(half.map(qint64(INT_MAX) + 1), (qint64(INT_MAX) + 1) / 2);
+    QCOMPARE(half.unmap(qint64(INT_MAX)), 2 * qint64(INT_MAX));
+}
+
+void TestLargeIndex::readBlocksAcrossIntMax()
+{
+    // чтение нескольких блоков, не выровненных по размеру блока, через INT_MAX
+    const qint64 count = (3 << 20) + 123;
+    const qint64 first = qint64(INT_MAX) - count / 2;
+    std::vector<double> samples(count);
+    QCOMPARE(EDFReader::readPhysicalSamples(mEDFHeader.handle, 0, first, count, samples.data()), count);
+    QCOMPARE(qint64(edftell(mEDFHeader.handle, 0)), first + count);
+    for (qint64 i = 0; i < count; i++) {
+        if (samples[i] != getExpectedValue(first + i)) {
+            QFAIL(qPrintable(QString("sample %1: %2 != %3").arg(first + i).arg(samples[i]).arg(getExpectedValue(first + i))));
+        }
+    }
+}
+
+void TestLargeIndex::readTail()
+{
+    // в конце канала читается меньше запрошенного
+    const qint64 first = getSamplesCount() - 1000;
+    std::vector<double> samples(5000);
+    QCOMPARE(EDFReader::readPhysicalSamples(mEDFHeader.handle, 0, first, 5000, samples.data()), qint64(1000));
+    for (qint64 i = 0; i < 1000; i++) {
+        QCOMPARE(samples[i], getExpectedValue(first + i));
+    }
+}
+
+void TestLargeIndex::pyramidRangesAcrossIntMax()
+{
+#ifdef Q_OS_LINUX
+    // пирамида над 2^31 отсчетами занимает около 4.6 ГБ, отсчеты - незатронутые нулевые страницы
+    qint64 levelsSize = (TEST_PYRAMID_SAMPLES / MinMaxPyramid::LEVEL_FACTOR) * qint64(sizeof(MinMaxPyramid::Bucket)) * 8 / 7;
+    qint64 availableSize = 0;
+    QFile meminfo("/proc/meminfo");
+    if (meminfo.open(QIODevice::ReadOnly)) {
+        for (QByteArray line = meminfo.readLine(); !line.isEmpty(); line = meminfo.readLine()) {
+            if (line.startsWith("MemAvailable:")) {
+                availableSize = line.mid(13).trimmed().split(' ').first().toLongLong() * 1024;
+            }
+        }
+    }
+    if (availableSize < levelsSize + (qint64(256) << 20)) {
+        QSKIP("not enough memory for a pyramid over 2^31 samples");
+    }
+    size_t mappingSize = size_t(TEST_PYRAMID_SAMPLES) * sizeof(double);
+    void * pMapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    QVERIFY(pMapping != MAP_FAILED);
+    double * pSamples = static_cast<double *>(pMapping);
+
+    // значения около INT_MAX и выбросы по обе стороны от него
+    const qint64 center = qint64(INT_MAX);
+    for (qint64 i = center - (1 << 16); i < center + (1 << 16); i++) {
+        pSamples[i] = double(i % 1000);
+    }
+    pSamples[center - 7] = -1e6;
+    pSamples[center + 5] = 1e6;
+
+    MinMaxPyramid pyramid;
+    pyramid.build(pSamples, TEST_PYRAMID_SAMPLES);
+    QCOMPARE(pyramid.getBucketCount(-1), TEST_PYRAMID_SAMPLES);
+    QCOMPARE(pyramid.getBucketCount(0), TEST_PYRAMID_SAMPLES / MinMaxPyramid::LEVEL_FACTOR);
+    QCOMPARE(pyramid.getBucketCount(pyramid.getLevelCount() - 1), qint64(1));
+
+    for (int level = -1; level < pyramid.getLevelCount(); level++) {
+        qint64 bucketSize = pyramid.getBucketSize(level);
+        if (level >= 0) {
+            QCOMPARE(pyramid.findLevel(double(bucketSize)), level);
+            QCOMPARE(pyramid.findLevel(double(bucketSize) - 1), level - 1);
+        }
+        // диапазон с обоими выбросами (конец диапазона выравнивается вниз, поэтому он продлен на блок)
+        MinMaxPyramid::Bucket range = pyramid.getRange(level, center - 7, center + 5 + bucketSize, pSamples);
+        QCOMPARE(range.minValue, -1e6f);
+        QCOMPARE(range.maxValue, 1e6f);
+        // диапазон целиком выше INT_MAX: сверка с прямым проходом по границам блоков уровня
+        if (bucketSize > (1 << 12)) {
+            continue;
+        }
+        qint64 beginSample = center + 6;
+        qint64 endSample = center + 3000;
+        range = pyramid.getRange(level, beginSample, endSample, pSamples);
+        qint64 alignedBegin = beginSample / bucketSize * bucketSize;
+        qint64 alignedEnd = qMax(endSample / bucketSize, beginSample / bucketSize + 1) * bucketSize;
+        double minValue = pSamples[alignedBegin];
+        double maxValue = pSamples[alignedBegin];
+        for (qint64 i = alignedBegin; i < alignedEnd; i++) {
+            minValue = qMin(minValue, pSamples[i]);
+            maxValue = qMax(maxValue, pSamples[i]);
+        }
+        QCOMPARE(range.minValue, float(minValue));
+        QCOMPARE(range.maxValue, float(maxValue));
+        QCOMPARE(range.firstValue, float(pSamples[alignedBegin]));
+        QCOMPARE(range.lastValue, float(pSamples[alignedEnd - 1]));
+    }
+    pyramid.clear();
+    munmap(pMapping, mappingSize);
+#else
+    QSKIP("the pyramid over 2^31 samples needs lazily zeroed memory (Linux only)");
+#endif
+}
+
+QTEST_APPLESS_MAIN(TestLargeIndex)
+
+#include "tst_largeindex.moc"
@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Сопоставление R-зубцов и опорных точек пульсовых волн (синтетическая запись)
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_timelag
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += tst_timelag.cpp \
+        $$SRC/timelagmatcher.cpp
+
+HEADERS  += $$SRC/timelagmatcher.h
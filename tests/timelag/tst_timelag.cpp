@@ -0,0 +1,127 @@
+#include <QtTest>
+#include <math.h>
+#include <vector>
+#include "timelagmatcher.h"
+
+// частоты каналов ЭКГ и плетизмограммы, Гц
+#define TEST_RATE_ECG 500
+#define TEST_RATE_P 125
+// период пульсовой волны, отсчетов плетизмограммы (ЧСС 75), и количество волн
+#define TEST_PERIOD 100
+#define TEST_BEATS 20
+// положение в периоде основания, точки наибольшей крутизны и вершины волны, отсчетов плетизмограммы
+#define TEST_FOOT 20
+#define TEST_MAX_SLOPE 30
+#define TEST_PEAK 40
+// R-зубец опережает основание волны на TEST_FOOT_LAG_S, с
+#define TEST_FOOT_LAG_S 0.1
+
+class TestTimeLag : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void fiducialPeak();
+    void fiducialFoot();
+    void fiducialMaxSlope();
+    void lagRange();
+
+private:
+    // пики ЭКГ и плетизмограммы, отсчеты плетизмограммы
+    std::vector<qint64> mPeaksECG;
+    std::vector<qint64> mPeaksP;
+    std::vector<double> mSamplesP;
+
+    // сверка задержек: expectedLagS в отсчетах пиков плетизмограммы (со сдвигом на shift волн), нули в остальных
+    static bool checkLags(const std::vector<double> & timeLag, const std::vector<qint64> & peaksP,
+                          int shift, double expectedLagS);
+    // задержки при заданной опорной точке и диапазоне
+    std::vector<double> match(int fiducial, double minLagS, double maxLagS) const;
+};
+
+void TestTimeLag::initTestCase()
+{
+    // волна: подъем от основания до вершины по 0.02 за отсчет со ступенькой 0.2 в TEST_MAX_SLOPE,
+    // затем линейный спад до основания следующей волны (основание - единственный минимум между вершинами)
+    mSamplesP.resize(size_t(TEST_PERIOD) * TEST_BEATS);
+    double peakValue = 0.02 * (TEST_PEAK - TEST_FOOT) + 0.2;
+    for (qint64 i = 0; i < qint64(mSamplesP.size()); i++) {
+        qint64 phase = (i % TEST_PERIOD - TEST_FOOT + TEST_PERIOD) % TEST_PERIOD;
+        if (phase <= TEST_PEAK - TEST_FOOT) {
+            mSamplesP[i] = 0.02 * phase + (phase >= TEST_MAX_SLOPE - TEST_FOOT ? 0.2 : 0);
+        } else {
+            mSamplesP[i] = peakValue * double(TEST_PERIOD - phase) / double(TEST_PERIOD - (TEST_PEAK - TEST_FOOT));
+        }
+    }
+    for (int beat = 0; beat < TEST_BEATS; beat++) {
+        qint64 footP = qint64(beat) * TEST_PERIOD + TEST_FOOT;
+        mPeaksP.push_back(qint64(beat) * TEST_PERIOD + TEST_PEAK);
+        mPeaksECG.push_back(qint64(llround((double(footP) / TEST_RATE_P - TEST_FOOT_LAG_S) * TEST_RATE_ECG)));
+    }
+    QVERIFY(mPeaksECG.front() >= 0);
+}
+
+bool TestTimeLag::checkLags(const std::vector<double> & timeLag, const std::vector<qint64> & peaksP,
+                            int shift, double expectedLagS)
+{
+    std::vector<double> expected(timeLag.size(), 0.0);
+    for (size_t beat = size_t(shift); beat < peaksP.size(); beat++) {
+        expected[size_t(peaksP[beat])] = expectedLagS;
+    }
+    for (size_t i = 0; i < timeLag.size(); i++) {
+        if (fabs(timeLag[i] - expected[i]) > 1e-9) {
+            printf("sample %zu: lag %f, expected %f\n", i, timeLag[i], expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<double> TestTimeLag::match(int fiducial, double minLagS, double maxLagS) const
+{
+    TimeLagMatcher matcher;
+    matcher.setFiducial(fiducial);
+    matcher.setLagRange(minLagS, maxLagS);
+    std::vector<double> timeLag(mSamplesP.size(), -1.0);
+    matcher.match(mPeaksECG, TEST_RATE_ECG, mPeaksP, mSamplesP.data(), TEST_RATE_P,
+                  timeLag.data(), qint64(timeLag.size()));
+    return timeLag;
+}
+
+void TestTimeLag::fiducialPeak()
+{
+    // по умолчанию - вершина волны
+    TimeLagMatcher matcher;
+    std::vector<double> timeLag(mSamplesP.size(), -1.0);
+    matcher.match(mPeaksECG, TEST_RATE_ECG, mPeaksP, mSamplesP.data(), TEST_RATE_P,
+                  timeLag.data(), qint64(timeLag.size()));
+    QVERIFY(checkLags(timeLag, mPeaksP, 0, TEST_FOOT_LAG_S + double(TEST_PEAK - TEST_FOOT) / TEST_RATE_P));
+}
+
+void TestTimeLag::fiducialFoot()
+{
+    std::vector<double> timeLag = match(FIDUCIAL_FOOT, 0, 2);
+    QVERIFY(checkLags(timeLag, mPeaksP, 0, TEST_FOOT_LAG_S));
+}
+
+void TestTimeLag::fiducialMaxSlope()
+{
+    std::vector<double> timeLag = match(FIDUCIAL_MAX_SLOPE, 0, 2);
+    QVERIFY(checkLags(timeLag, mPeaksP, 0, TEST_FOOT_LAG_S + double(TEST_MAX_SLOPE - TEST_FOOT) / TEST_RATE_P));
+}
+
+void TestTimeLag::lagRange()
+{
+    double periodS = double(TEST_PERIOD) / TEST_RATE_P;
+    // основание своей волны ближе minLag: R-зубец сопоставляется со следующей волной
+    std::vector<double> timeLag = match(FIDUCIAL_FOOT, TEST_FOOT_LAG_S + 0.05, 2);
+    QVERIFY(checkLags(timeLag, mPeaksP, 1, TEST_FOOT_LAG_S + periodS));
+    // задержка до следующей волны больше maxLag: задержки не записываются
+    timeLag = match(FIDUCIAL_FOOT, TEST_FOOT_LAG_S + 0.05, TEST_FOOT_LAG_S + periodS - 0.05);
+    QVERIFY(checkLags(timeLag, mPeaksP, TEST_BEATS, 0));
+}
+
+QTEST_APPLESS_MAIN(TestTimeLag)
+
+#include "tst_timelag.moc"